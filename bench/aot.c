@@ -0,0 +1,91 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o aot bench/aot.c -lm
+ */
+
+#include "bench.h"
+
+static const char *setup =
+    "var a\nvar b\nvar n\nvar i\nvar s\nfvar x\n"
+    ": fib n ! 0 a ! 1 b ! begin a @ b @ + b @ a ! b ! n @ 1 - dup n ! 0 <= until ;\n"
+    ": fibs 0 i ! begin 40 fib i ++ i @ 1000000 >= until a @ . ;\n"
+    ": sums 0 s ! 0 i ! begin i @ dup * 7 % s +! i ++ i @ 30000000 >= until s @ . ;\n"
+    ": fsums 0.0 x f! 0 i ! begin i @ i2f 0.5 f* x f+! i ++ i @ 20000000 >= until x f@ f. ;\n"
+    ": tri dup 0 > if dup 1 - tri + then ;\n"
+    ": tris 0 s ! 0 i ! begin 1000 tri s +! i ++ i @ 20000 >= until s @ . ;\n";
+
+static const char *runs[] = {"fibs", "sums", "fsums", "tris", NULL};
+
+typedef struct Buffer {
+    char data[256];
+    size_t size;
+} Buffer;
+
+static void sink(void *ctx, const char *buf, size_t len) {
+    Buffer *b = (Buffer *) ctx;
+    if (len > sizeof(b->data) - 1 - b->size) len = sizeof(b->data) - 1 - b->size;
+    memcpy(b->data + b->size, buf, len);
+    b->size += len;
+    b->data[b->size] = '\0';
+}
+
+static double interp(const char *script, int jit, Buffer *out) {
+    F_State *state = F_createState();
+    F_initState(state);
+    state->jit = jit;
+    F_setSink(state, sink, out);
+    double t = now();
+    F_execScript(state, script);
+    F_flush(state);
+    t = now() - t;
+    F_destroyState(state);
+    return t;
+}
+
+int main(void) {
+    char src[256], script[] = "/tmp/foo_aot_bench.foo", csrc[] = "/tmp/foo_aot_bench.c";
+    char bin[] = "/tmp/foo_aot_bench", out[] = "/tmp/foo_aot_bench.out", cmd[1024];
+    strcpy(src, __FILE__);
+    char *slash = strrchr(src, '/');
+    strcpy(slash ? slash + 1 : src, "../src");
+    printf("%-8s %10s %10s %10s %10s %8s\n", "word", "interp", "jit", "compile", "aot", "speedup");
+    for (int k = 0; runs[k]; k++) {
+        FILE *f = fopen(script, "w");
+        fprintf(f, "%s%s\nbye\n", setup, runs[k]);
+        fclose(f);
+        Buffer a = {{0}, 0}, b = {{0}, 0};
+        double ti = interp(script, 0, &a), tj = interp(script, 1, &b);
+        F_State *state = F_createState();
+        F_initState(state);
+        f = fopen(csrc, "w");
+        int err = F_emitC(state, script, f);
+        fclose(f);
+        F_destroyState(state);
+        if (err) return 1;
+        snprintf(cmd, sizeof(cmd), "cc -O2 -I%s -o %s %s -lm", src, bin, csrc);
+        double tc = now();
+        if (system(cmd)) return 1;
+        tc = now() - tc;
+        snprintf(cmd, sizeof(cmd), "%s > %s", bin, out);
+        double ta = now();
+        if (system(cmd)) return 1;
+        ta = now() - ta;
+        Buffer c = {{0}, 0};
+        f = fopen(out, "r");
+        c.size = fread(c.data, 1, sizeof(c.data) - 1, f);
+        fclose(f);
+        int same = !strcmp(a.data, b.data) && !strcmp(a.data, c.data);
+        printf("%-8s %8.3f s %8.3f s %8.3f s %8.3f s %7.2fx%s\n", runs[k], ti, tj, tc, ta, ti / ta,
+               same ? "" : "  (output differs)");
+    }
+    remove(script);
+    remove(csrc);
+    remove(bin);
+    remove(out);
+    return 0;
+}
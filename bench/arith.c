@@ -0,0 +1,31 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o arith bench/arith.c -lm
+ */
+
+#include "bench.h"
+
+static const char *setup[] = {
+    "var i", "var s",
+    "fvar x",
+    ": poly dup dup * 3 * swp 5 * + 7 + 1000 % ;",
+    ": ipoly 0 s ! 0 i ! begin i @ poly s @ + s ! i @ 1 + dup i ! 5000000 >= until ;",
+    ": istack 0 i ! begin i @ dup dup + swp - dup * dup 3 + swp - .x i ++ i @ 5000000 >= until ;",
+    ": fpoly 0.0 x f! 0 i ! begin i @ i2f fdup fdup f* 0.5 f* fswp 1.5 f* f+ x f@ f+ x f! i ++ i @ 3000000 >= until ;",
+    NULL
+};
+
+static const char *runs[] = {"ipoly", "istack", "fpoly", NULL};
+
+int main(void) {
+    F_State *state = bench_state();
+    bench_load(state, setup);
+    for (int i = 0; runs[i]; i++) printf("%-8s %8.3f s\n", runs[i], bench_best(state, runs[i], 5));
+    F_destroyState(state);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+#include "../src/foo.h"
+
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+F_State *bench_state(void) {
+    F_State *state = F_createState();
+    F_initState(state);
+    state->interactive = 0;
+    return state;
+}
+
+void bench_load(F_State *state, const char **setup) {
+    for (int i = 0; setup[i]; i++) {
+        char line[1024];
+        strcpy(line, setup[i]);
+        if (line[0] == ':') F_compile(state, line);
+        else F_eval(state, line);
+    }
+}
+
+double bench_run(F_State *state, const char *word) {
+    char line[F_MAX_WORD];
+    strcpy(line, word);
+    double t = now();
+    F_eval(state, line);
+    return now() - t;
+}
+
+double bench_best(F_State *state, const char *word, int rounds) {
+    double best = 1e9;
+    for (int k = 0; k < rounds; k++) {
+        double t = bench_run(state, word);
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+#ifdef F_UNIX
+long rss_kb(void) {
+    long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+#endif
+
+#endif
@@ -0,0 +1,48 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/* gcc -O2 -o dict_lookup bench/dict_lookup.c -lm */
+
+#include "bench.h"
+
+#define ROUNDS 1000000
+
+static F_DictEntry *linear_find(F_State *state, const char *word) {
+    F_Dict *dict = state->dict;
+    for (int i = 0; i < dict->size; i++) {
+        if (!strcmp(word, dict->entry[i].word))
+            return &dict->entry[i];
+    }
+    return NULL;
+}
+
+int main(void) {
+    int sizes[] = {100, 1000, 10000};
+    char word[F_MAX_WORD];
+    printf("%8s %14s %14s\n", "entries", "hash ns/op", "linear ns/op");
+    for (int s = 0; s < 3; s++) {
+        F_State *state = F_createState();
+        F_initState(state);
+        for (int i = state->dict->size; i < sizes[s]; i++) {
+            sprintf(word, "word%d", i);
+            F_addExpr(state, word, "1");
+        }
+        sprintf(word, "word%d", sizes[s] - 1);
+        const char *volatile key = word;
+        F_DictEntry *volatile sink = NULL;
+        double t = now();
+        for (int i = 0; i < ROUNDS; i++) sink = F_find(state, key);
+        double hash = (now() - t) / ROUNDS * 1e9;
+        int rounds = ROUNDS / sizes[s] * 100;
+        t = now();
+        for (int i = 0; i < rounds; i++) sink = linear_find(state, key);
+        double linear = (now() - t) / rounds * 1e9;
+        (void)sink;
+        printf("%8d %14.1f %14.1f\n", state->dict->size, hash, linear);
+        F_destroyState(state);
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o dispatch bench/dispatch.c -lm
+ * gcc -O2 -DF_DISPATCH_SWITCH -o dispatch_switch bench/dispatch.c -lm
+ */
+
+#include "bench.h"
+
+static const char *setup[] = {
+    "var a", "var b", "var n", "var i", "var s",
+    "fvar x",
+    ": fib n ! 0 a ! 1 b ! begin a @ b @ + b @ a ! b ! n @ 1 - dup n ! 0 <= until ;",
+    ": fibs 0 i ! begin 40 fib i ++ i @ 100000 >= until ;",
+    ": sums 0 s ! 0 i ! begin i @ dup * 7 % s +! i ++ i @ 3000000 >= until ;",
+    ": fsums 0.0 x f! 0 i ! begin i @ i2f 0.5 f* x f+! i ++ i @ 2000000 >= until ;",
+    NULL
+};
+
+static const char *runs[] = {"fibs", "sums", "fsums", NULL};
+
+int main(void) {
+    F_State *state = bench_state();
+    bench_load(state, setup);
+#ifdef F_THREADED
+    printf("dispatch: computed goto\n");
+#else
+    printf("dispatch: switch\n");
+#endif
+    for (int i = 0; runs[i]; i++) printf("%-8s %8.3f s\n", runs[i], bench_run(state, runs[i]));
+    F_destroyState(state);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o image bench/image.c -lm
+ */
+
+#include "bench.h"
+
+#define ROUNDS 200
+
+static const char *module = "/tmp/foo_image_bench";
+static const char *image = "/tmp/foo_image_bench.img";
+
+static F_State *cold(void) {
+    F_State *state = bench_state();
+    state->module_cache = 0;
+    char line[256];
+    sprintf(line, "#%s", module);
+    F_import(state, line);
+    for (int i = 0; i < 100; i++) {
+        sprintf(line, "%d var v%d", i, i);
+        F_eval(state, line);
+    }
+    return state;
+}
+
+static F_State *warm(void) {
+    F_State *state = bench_state();
+    F_loadImage(state, image);
+    return state;
+}
+
+static double run(F_State *(*boot)(void)) {
+    double best = 1e9;
+    for (int k = 0; k < 5; k++) {
+        double t = now();
+        for (int i = 0; i < ROUNDS; i++) F_destroyState(boot());
+        t = (now() - t) / ROUNDS;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(void) {
+    char path[256];
+    sprintf(path, "%s.foo", module);
+    FILE *f = fopen(path, "w");
+    for (int i = 0; i < 500; i++)
+        fprintf(f, ": w%d %d dup * %d + 7 %% begin 1 - dup 0 <= until .x ;\n", i, i, i);
+    fclose(f);
+
+    F_State *state = cold();
+    F_saveImage(state, image);
+    F_destroyState(state);
+
+    state = warm();
+    char line[] = "5 w499 v99 ? depth .";
+    F_eval(state, line);
+    F_flush(state);
+    F_destroyState(state);
+
+    printf("cold init  %8.1f us\n", run(cold) * 1e6);
+    printf("image load %8.1f us\n", run(warm) * 1e6);
+    remove(path);
+    remove(image);
+    return 0;
+}
@@ -0,0 +1,51 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o inline bench/inline.c -lm
+ */
+
+#include "bench.h"
+
+static const char *setup[] = {
+    "var i", "var s",
+    "fvar x",
+    ": square dup * ;",
+    ": inc 1 + ;",
+    ": mod7 7 % ;",
+    ": fhalf 0.5 f* ;",
+    ": squares 0 s ! 0 i ! begin i @ square mod7 s +! i @ inc i ! i @ 3000000 >= until ;",
+    ": fsums 0.0 x f! 0 i ! begin i @ i2f fhalf x f+! i @ inc i ! i @ 3000000 >= until ;",
+    ": nested 0 s ! 0 i ! begin i @ inc inc square mod7 inc s +! i ++ i @ 3000000 >= until ;",
+    NULL
+};
+
+static const char *runs[] = {"squares", "fsums", "nested", NULL};
+
+static F_State *make(int inlining, int jit) {
+    F_State *state = bench_state();
+    state->inlining = inlining;
+    state->jit = jit;
+    bench_load(state, setup);
+    return state;
+}
+
+int main(void) {
+    for (int jit = 0; jit < 2; jit++) {
+        F_State *call = make(0, jit);
+        F_State *inl = make(1, jit);
+        printf("%s\n%-8s %10s %10s %8s\n", jit ? "jit" : "interpreter", "word", "call", "inline", "speedup");
+        for (int i = 0; runs[i]; i++) {
+            double a = bench_run(call, runs[i]);
+            double b = bench_run(inl, runs[i]);
+            printf("%-8s %8.3f s %8.3f s %7.2fx\n", runs[i], a, b, a / b);
+        }
+        printf("inlined: %d\n", inl->inlined);
+        F_destroyState(call);
+        F_destroyState(inl);
+    }
+    return 0;
+}
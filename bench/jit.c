@@ -0,0 +1,53 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o jit bench/jit.c -lm
+ * gcc -O2 -DF_DISPATCH_SWITCH -o jit_switch bench/jit.c -lm
+ */
+
+#include "bench.h"
+
+static const char *setup[] = {
+    "var a", "var b", "var n", "var i", "var s",
+    "fvar x",
+    ": fib n ! 0 a ! 1 b ! begin a @ b @ + b @ a ! b ! n @ 1 - dup n ! 0 <= until ;",
+    ": fibs 0 i ! begin 40 fib i ++ i @ 100000 >= until ;",
+    ": sums 0 s ! 0 i ! begin i @ dup * 7 % s +! i ++ i @ 3000000 >= until ;",
+    ": fsums 0.0 x f! 0 i ! begin i @ i2f 0.5 f* x f+! i ++ i @ 2000000 >= until ;",
+    ": tri dup 0 > if dup 1 - tri + then ;",
+    ": tris 0 i ! begin 200 tri .x i ++ i @ 20000 >= until ;",
+    NULL
+};
+
+static const char *runs[] = {"fibs", "sums", "fsums", "tris", NULL};
+
+static F_State *make(int jit) {
+    F_State *state = bench_state();
+    state->jit = jit;
+    bench_load(state, setup);
+    return state;
+}
+
+int main(void) {
+    F_State *interp = make(0);
+    F_State *jit = make(1);
+#ifdef F_THREADED
+    printf("dispatch: computed goto\n");
+#else
+    printf("dispatch: switch\n");
+#endif
+    printf("%-8s %10s %10s %8s\n", "word", "interp", "jit", "speedup");
+    for (int i = 0; runs[i]; i++) {
+        double a = bench_run(interp, runs[i]);
+        double b = bench_run(jit, runs[i]);
+        printf("%-8s %8.3f s %8.3f s %7.2fx\n", runs[i], a, b, a / b);
+    }
+    printf("jitted: %d\n", jit->jitted);
+    F_destroyState(interp);
+    F_destroyState(jit);
+    return 0;
+}
@@ -0,0 +1,63 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o lazy bench/lazy.c -lm
+ */
+
+#include "bench.h"
+
+#define WORDS 5000
+#define ROUNDS 20
+
+static const char *module = "/tmp/foo_lazy_bench.foo";
+static const char *cache = "/tmp/foo_lazy_bench.fooc";
+
+static F_State *boot(int lazy, int use_cache) {
+    F_State *state = bench_state();
+    state->lazy = lazy;
+    state->module_cache = use_cache;
+    F_importFile(state, module);
+    for (int i = 0; i < 10; i++) {
+        char line[64];
+        sprintf(line, "%d w%d .x", i, i * (WORDS / 10) + 7);
+        F_eval(state, line);
+    }
+    return state;
+}
+
+static double run(int lazy, int use_cache) {
+    double best = 1e9;
+    for (int k = 0; k < 5; k++) {
+        double t = now();
+        for (int i = 0; i < ROUNDS; i++) F_destroyState(boot(lazy, use_cache));
+        t = (now() - t) / ROUNDS;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(void) {
+    FILE *f = fopen(module, "w");
+    for (int i = 0; i < 10; i++)
+        fprintf(f, ": w%d %d + ;\n", i, i);
+    for (int i = 10; i < WORDS; i++)
+        fprintf(f, ": w%d w%d %d + dup 7 %% begin 1 - dup 0 <= until .x ;\n", i, i % 10, i);
+    fclose(f);
+    remove(cache);
+
+    F_State *state = boot(1, 0);
+    printf("%d deferred, %d materialized\n", state->deferred, state->materialized);
+    F_destroyState(state);
+
+    printf("eager  %8.1f us\n", run(0, 0) * 1e6);
+    printf("lazy   %8.1f us\n", run(1, 0) * 1e6);
+    F_destroyState(boot(0, 1));
+    printf("cached %8.1f us\n", run(1, 1) * 1e6);
+    remove(module);
+    remove(cache);
+    return 0;
+}
@@ -0,0 +1,48 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o locals bench/locals.c -lm
+ */
+
+#include "bench.h"
+
+static const char *setup[] = {
+    "var a", "var b", "var n", "var i", "var s",
+    "fvar x", "fvar y",
+    ": gfib n ! 0 a ! 1 b ! begin a @ b @ + b @ a ! b ! n @ 1 - dup n ! 0 <= until a @ ;",
+    ": lfib { n | a b -- } 1 to b begin a b + b to a to b n 1 - dup to n 0 <= until a ;",
+    ": gfpow y f! x f! 1.0 begin x f@ f* y f@ 1.0 f- fdup y f! 0.0 f<= until ;",
+    ": lfpow { f: x f: y -- } 1.0 begin x f* y 1.0 f- to y y 0.0 f<= until ;",
+    ": gfibs 0 i ! begin 40 gfib s ! i ++ i @ 1000000 >= until ;",
+    ": lfibs 0 i ! begin 40 lfib s ! i ++ i @ 1000000 >= until ;",
+    ": gfpows 0 i ! begin 1.0001 40.0 gfpow f.x i ++ i @ 1000000 >= until ;",
+    ": lfpows 0 i ! begin 1.0001 40.0 lfpow f.x i ++ i @ 1000000 >= until ;",
+    NULL
+};
+
+static const char *runs[][2] = {{"gfibs", "lfibs"}, {"gfpows", "lfpows"}, {NULL, NULL}};
+
+static F_State *make(int jit) {
+    F_State *state = bench_state();
+    state->jit = jit;
+    bench_load(state, setup);
+    return state;
+}
+
+int main(void) {
+    for (int jit = 0; jit < 2; jit++) {
+        F_State *state = make(jit);
+        printf("%s\n%-8s %10s %10s %8s\n", jit ? "jit" : "interpreter", "word", "global", "locals", "speedup");
+        for (int i = 0; runs[i][0]; i++) {
+            double a = bench_run(state, runs[i][0]);
+            double b = bench_run(state, runs[i][1]);
+            printf("%-8s %8.3f s %8.3f s %7.2fx\n", runs[i][1] + 1, a, b, a / b);
+        }
+        F_destroyState(state);
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o modcache bench/modcache.c -lm
+ */
+
+#include "bench.h"
+
+#define ROUNDS 50
+
+static const char *module = "/tmp/foo_modcache_bench.foo";
+static const char *cache = "/tmp/foo_modcache_bench.fooc";
+
+static F_State *boot(int use_cache) {
+    F_State *state = bench_state();
+    state->module_cache = use_cache;
+    state->lazy = 0;
+    F_importFile(state, module);
+    return state;
+}
+
+static double run(int use_cache) {
+    double best = 1e9;
+    for (int k = 0; k < 5; k++) {
+        double t = now();
+        for (int i = 0; i < ROUNDS; i++) F_destroyState(boot(use_cache));
+        t = (now() - t) / ROUNDS;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(void) {
+    FILE *f = fopen(module, "w");
+    fprintf(f, ": w0 1 + ;\n");
+    for (int i = 1; i < 2000; i++)
+        fprintf(f, ": w%d w%d %d + dup 7 %% begin 1 - dup 0 <= until .x ;\n", i, i - 1, i);
+    fclose(f);
+    remove(cache);
+
+    F_destroyState(boot(1));
+    F_State *state = boot(1);
+    char line[] = "5 w1999 .";
+    F_eval(state, line);
+    F_flush(state);
+    F_destroyState(state);
+
+    printf("source import %8.1f us\n", run(0) * 1e6);
+    printf("cached import %8.1f us\n", run(1) * 1e6);
+    remove(module);
+    remove(cache);
+    return 0;
+}
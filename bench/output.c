@@ -0,0 +1,53 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o output bench/output.c -lm
+ * ./output > /dev/null
+ */
+
+#include "bench.h"
+
+static const char *setup[] = {
+    "var i",
+    ": ints 0 i ! begin i @ . i ++ i @ 10000000 >= until ;",
+    ": floats 0 i ! begin i @ i2f 0.37 f* f. i ++ i @ 2000000 >= until ;",
+    NULL
+};
+
+static const char *runs[] = {"ints", "floats", NULL};
+
+int main(void) {
+    double t = now();
+    for (int i = 0; i < 10000000; i++) printf("%d\n", i);
+    fflush(stdout);
+    fprintf(stderr, "%-8s %8.3f s\n", "printf", now() - t);
+    t = now();
+    for (int i = 0; i < 2000000; i++) printf("%f\n", i * 0.37);
+    fflush(stdout);
+    fprintf(stderr, "%-8s %8.3f s\n", "printf f", now() - t);
+
+    F_State *state = bench_state();
+    bench_load(state, setup);
+    for (int i = 0; runs[i]; i++) {
+        char line[F_MAX_WORD];
+        strcpy(line, runs[i]);
+        t = now();
+        F_eval(state, line);
+        F_flush(state);
+        fprintf(stderr, "%-8s %8.3f s\n", runs[i], now() - t);
+    }
+#ifdef F_UNIX
+    F_setSink(state, F_fdSink, (void *) (intptr_t) STDOUT_FILENO);
+    char line[F_MAX_WORD] = "ints";
+    t = now();
+    F_eval(state, line);
+    F_flush(state);
+    fprintf(stderr, "%-8s %8.3f s\n", "ints fd", now() - t);
+#endif
+    F_destroyState(state);
+    return 0;
+}
@@ -0,0 +1,49 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o peephole bench/peephole.c -lm
+ * gcc -O2 -DF_COUNT_INSTS -o peephole_count bench/peephole.c -lm
+ */
+
+#include "bench.h"
+
+static const char *setup[] = {
+    "var a", "var b", "var n", "var i", "var j", "var s",
+    ": fib n ! 0 a ! 1 b ! begin a @ b @ + b @ a ! dup b ! n @ > until ;",
+    ": fibs 0 j ! begin 1000000000 fib j ++ j @ 200000 >= until ;",
+    ": _log2 n @ 0 > if n @ 2 / n ! i ++ _log2 then ;",
+    ": log2 n ! 0 i ! _log2 i @ 1 - ;",
+    ": log2s 0 j ! begin 1000000000 log2 .x j ++ j @ 200000 >= until ;",
+    ": loop 0 s ! 0 i ! begin i @ dup * 7 % s +! i @ 3 > if s -- then i ++ i @ 3000000 >= until ;",
+    NULL
+};
+
+static const char *runs[] = {"fibs", "log2s", "loop", NULL};
+
+int main(void) {
+    for (int on = 0; on <= 1; on++) {
+        F_State *state = bench_state();
+        state->peephole = on;
+        bench_load(state, setup);
+        printf("peephole %s\n", on ? "on" : "off");
+        for (int i = 0; runs[i]; i++) {
+            state->steps = 0;
+            double t = bench_run(state, runs[i]);
+#ifdef F_COUNT_INSTS
+            printf("  %-8s %8.3f s %12lld insts\n", runs[i], t, state->steps);
+#else
+            printf("  %-8s %8.3f s\n", runs[i], t);
+#endif
+        }
+        if (on) {
+            printf("fusions:\n");
+            F_printFused(state);
+        }
+        F_destroyState(state);
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o profile bench/profile.c -lm
+ */
+
+#include "bench.h"
+
+static const char *setup[] = {
+    "var i",
+    ": sq dup * ;",
+    ": fib dup 2 < if else dup 1 - fib swp 2 - fib + then ;",
+    ": loop 0 i ! begin i @ sq .x i ++ i @ 3000000 >= until ;",
+    ": run 27 fib .x loop ;",
+    NULL
+};
+
+int main(void) {
+    F_State *state = bench_state();
+    bench_load(state, setup);
+    double off = bench_best(state, "run", 5);
+    F_profileStart(state);
+    double on = bench_best(state, "run", 5);
+    F_profileStop(state);
+    double after = bench_best(state, "run", 5);
+    printf("never started %8.3f s\n", off);
+    printf("profiling     %8.3f s (%.1fx)\n", on, on / off);
+    printf("after stop    %8.3f s (%+.1f%%)\n", after, (after / off - 1) * 100);
+    F_profileDump(state, stdout, F_PROFILE_TABLE);
+    F_destroyState(state);
+    return 0;
+}
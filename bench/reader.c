@@ -0,0 +1,92 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o reader bench/reader.c -lm
+ * ./reader [MB]
+ */
+
+#include "bench.h"
+
+static const char *path = "/tmp/foo_reader_bench.foo";
+
+static char line_buf[1 << 16];
+
+static int old_read(F_State *state, FILE *f) {
+    int c = fgetc(f);
+    int len = 0, comment = 0, nl = 0;
+    while (c != EOF) {
+        nl = 0;
+        if (c == '\\') {
+            comment = 1;
+            state->line_count++;
+        } else if (c == '\n' || c == '\r') {
+            nl = 1;
+            if (comment) comment = 0;
+            else break;
+        }
+        if (!comment && !nl)
+            line_buf[len++] = c;
+        c = fgetc(f);
+    }
+    line_buf[len] = '\0';
+    return c;
+}
+
+static double run_exec(void) {
+    F_State *state = F_createState();
+    F_initState(state);
+    double t = now();
+    F_execScript(state, path);
+    t = now() - t;
+    F_destroyState(state);
+    return t;
+}
+
+int main(int argc, char *argv[]) {
+    size_t mb = argc > 1 ? (size_t) atoi(argv[1]) : 50;
+    FILE *f = fopen(path, "w");
+    size_t bytes = 0, lines = 0;
+    while (bytes < mb << 20) {
+        bytes += fprintf(f, lines % 8 ? "%zu 3 * 7 + .x\n" : "\\ line %zu\n", lines);
+        lines++;
+    }
+    fclose(f);
+    printf("%zu MB, %zu lines\n", mb, lines);
+
+    F_State *state = F_createState();
+    size_t n = 0;
+    double t = now();
+    f = fopen(path, "r");
+    while (old_read(state, f) != EOF) n += line_buf[0] != '\0';
+    fclose(f);
+    t = now() - t;
+    printf("  fgetc   %8.3f s %8.1f MB/s (%zu)\n", t, mb / t, n);
+
+    F_Source src;
+    n = 0;
+    t = now();
+    F_openSource(&src, path);
+    while (F_readLine(state, &src, &state->line) != EOF) n += state->line[0] != '\0';
+    F_closeSource(&src);
+    t = now() - t;
+    printf("  mmap    %8.3f s %8.1f MB/s (%zu)\n", t, mb / t, n);
+
+    n = 0;
+    t = now();
+    f = fopen(path, "r");
+    F_streamSource(&src, f);
+    while (F_readLine(state, &src, &state->line) != EOF) n += state->line[0] != '\0';
+    F_closeSource(&src);
+    fclose(f);
+    t = now() - t;
+    printf("  stream  %8.3f s %8.1f MB/s (%zu)\n", t, mb / t, n);
+    F_destroyState(state);
+
+    printf("  exec    %8.3f s\n", run_exec());
+    remove(path);
+    return 0;
+}
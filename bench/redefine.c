@@ -0,0 +1,60 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o redefine bench/redefine.c -lm
+ */
+
+#include "bench.h"
+
+#define WORDS 5000
+#define LEAVES 100
+#define ROUNDS 50
+
+static void define(F_State *state, const char *fmt, int a, int b) {
+    char line[128];
+    sprintf(line, fmt, a, b);
+    F_compile(state, line);
+}
+
+static F_State *boot(void) {
+    F_State *state = bench_state();
+    for (int i = 0; i < LEAVES; i++) define(state, ": l%d %d + ;", i, i);
+    for (int i = 0; i < WORDS; i++) define(state, ": w%d l%d 1 + ;", i, i % LEAVES);
+    return state;
+}
+
+static void touch(F_State *state) {
+    char line[64];
+    for (int i = 0; i < WORDS; i++) {
+        sprintf(line, "0 0 w%d .x .x", i);
+        F_eval(state, line);
+    }
+}
+
+static double run(int global) {
+    F_State *state = boot();
+    touch(state);
+    double t = now();
+    for (int r = 0; r < ROUNDS; r++) {
+        define(state, r % 2 ? ": l%d swp dup .x swp %d + ;" : ": l%d %d + ;", r % LEAVES, r);
+        if (global) state->dict->version++;
+        touch(state);
+    }
+    t = (now() - t) / ROUNDS;
+    printf("%-12s %8.1f us/round  invalidated %d, recompiled %d, relinked %d\n",
+           global ? "global" : "incremental", t * 1e6,
+           state->invalidated / ROUNDS, state->recompiled / ROUNDS, state->relinked / ROUNDS);
+    F_destroyState(state);
+    return t;
+}
+
+int main(void) {
+    printf("%d words, %d leaves, %d redefinitions\n", WORDS, LEAVES, ROUNDS);
+    double a = run(0), b = run(1);
+    printf("speedup %.2fx\n", b / a);
+    return 0;
+}
@@ -0,0 +1,50 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o sample bench/sample.c -lm
+ */
+
+#include "bench.h"
+
+static const char *setup[] = {
+    "var i",
+    ": sq dup * ;",
+    ": fib dup 2 < if else dup 1 - fib swp 2 - fib + then ;",
+    ": loop 0 i ! begin i @ sq .x i ++ i @ 30000000 >= until ;",
+    ": run 32 fib .x loop ;",
+    NULL
+};
+
+int main(void) {
+    F_State *state = bench_state();
+    bench_load(state, setup);
+    double off = 1e9, on = 1e9;
+    for (int k = 0; k < 7; k++) {
+        double t = bench_run(state, "run");
+        if (t < off) off = t;
+        if (F_sampleStart(state, 1000) < 0) {
+            fprintf(stderr, "sampler unavailable\n");
+            return 1;
+        }
+        t = bench_run(state, "run");
+        F_sampleStop(state);
+        if (t < on) on = t;
+    }
+    int samples = 0;
+    for (int off = 0; off < state->sampler->size; off += state->sampler->buf[off + 1] + 2)
+        samples += state->sampler->buf[off];
+    printf("no sampler    %8.3f s\n", off);
+    printf("1 kHz sampler %8.3f s (%+.2f%%)\n", on, (on / off - 1) * 100);
+    printf("%d samples, %d stacks, %d dropped\n", samples, state->sampler->count, state->sampler->dropped);
+    FILE *out = fopen("/tmp/foo_sample_bench.folded", "w");
+    if (out) {
+        F_sampleDump(state, out);
+        fclose(out);
+    }
+    F_destroyState(state);
+    return 0;
+}
@@ -0,0 +1,113 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -pthread -o shared bench/shared.c -lm
+ */
+
+#include "bench.h"
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#define N 1000
+#define THREADS 8
+
+static const char *module = "/tmp/foo_shared_bench";
+
+static void load(F_State *state) {
+    char line[256];
+    sprintf(line, "#%s", module);
+    F_import(state, line);
+}
+
+static F_State *fresh(void) {
+    F_State *state = bench_state();
+    load(state);
+    return state;
+}
+
+static F_Dict *base;
+static F_State *states[N];
+
+static double resident(int shared) {
+    int fd[2];
+    double kb = 0;
+    if (pipe(fd) < 0) return 0;
+    pid_t pid = fork();
+    if (pid == 0) {
+        long before = rss_kb();
+        for (int i = 0; i < N; i++) states[i] = shared ? F_createStateFrom(base) : fresh();
+        kb = (double) (rss_kb() - before) / N;
+        if (write(fd[1], &kb, sizeof(kb)) != sizeof(kb)) _exit(1);
+        _exit(0);
+    }
+    close(fd[1]);
+    if (pid < 0 || read(fd[0], &kb, sizeof(kb)) != sizeof(kb)) kb = 0;
+    close(fd[0]);
+    if (pid > 0) waitpid(pid, NULL, 0);
+    return kb;
+}
+
+static void *worker(void *arg) {
+    long *sum = (long *) arg;
+    for (int i = 0; i < N; i++) {
+        F_State *state = F_createStateFrom(base);
+        state->interactive = 0;
+        char line[64];
+        sprintf(line, "%d sq3 w7 + x !", i % 100);
+        F_eval(state, line);
+        *sum += state->dict->vars[F_find(state, "x")->var_index];
+        F_destroyState(state);
+    }
+    return NULL;
+}
+
+int main(void) {
+    char path[256];
+    sprintf(path, "%s.foo", module);
+    FILE *f = fopen(path, "w");
+    for (int i = 0; i < 200; i++) fprintf(f, ": w%d %d dup * %d + ;\n", i, i, i);
+    fprintf(f, ": sq3 dup dup * * ;\n");
+    fclose(f);
+
+    F_State *builder = fresh();
+    F_eval(builder, (char[]) {"var x"});
+    base = F_freezeState(builder);
+
+    double private_kb = resident(0), shared_kb = resident(1);
+    double t, slow = 1e9, fast = 1e9;
+    for (int k = 0; k < 5; k++) {
+        t = now();
+        for (int i = 0; i < N; i++) F_destroyState(fresh());
+        t = (now() - t) / N;
+        if (t < slow) slow = t;
+        t = now();
+        for (int i = 0; i < N; i++) F_destroyState(F_createStateFrom(base));
+        t = (now() - t) / N;
+        if (t < fast) fast = t;
+    }
+    printf("init+import %8.2f us/VM\n", slow * 1e6);
+    printf("shared      %8.2f us/VM\n", fast * 1e6);
+
+    printf("resident    %8.1f KB/VM private, %.1f KB/VM shared\n", private_kb, shared_kb);
+
+    pthread_t tid[THREADS];
+    long sums[THREADS] = {0};
+    t = now();
+    for (int i = 0; i < THREADS; i++) pthread_create(&tid[i], NULL, worker, &sums[i]);
+    for (int i = 0; i < THREADS; i++) pthread_join(tid[i], NULL);
+    t = now() - t;
+    long total = 0;
+    for (int i = 0; i < THREADS; i++) total += sums[i];
+    printf("threads     %8.2f us/VM (%d x %d, checksum %ld)\n", t / (THREADS * N) * 1e6, THREADS, N, total);
+
+    F_destroyBase(base);
+    remove(path);
+    strcat(path, "c");
+    remove(path);
+    return 0;
+}
@@ -0,0 +1,40 @@
+/**********************************
+ *   Foo
+ *   Copyright (C) 2025 CoccusQ
+ *   MIT License
+ **********************************/
+
+/*
+ * gcc -O2 -o state bench/state.c -lm
+ */
+
+#include "bench.h"
+
+#define N 1000
+
+static F_State *states[N];
+
+int main(void) {
+    double best = 1e9;
+    for (int k = 0; k < 5; k++) {
+        double t = now();
+        for (int i = 0; i < N; i++) {
+            F_State *state = F_createState();
+            F_initState(state);
+            F_destroyState(state);
+        }
+        t = (now() - t) / N;
+        if (t < best) best = t;
+    }
+    printf("create+init+destroy %8.2f us/VM\n", best * 1e6);
+
+    long before = rss_kb();
+    for (int i = 0; i < N; i++) {
+        states[i] = F_createState();
+        F_initState(states[i]);
+    }
+    long after = rss_kb();
+    printf("resident            %8.1f KB/VM\n", (double) (after - before) / N);
+    for (int i = 0; i < N; i++) F_destroyState(states[i]);
+    return 0;
+}
@@ -7,19 +7,95 @@
  *   MIT License
  **********************************/
 
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#ifndef _DARWIN_C_SOURCE
+#define _DARWIN_C_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
 #include <errno.h>
-
+#include <limits.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#define F_UNIX
+#endif
+
+#ifdef __GNUC__
+#define F_PUBLISH() __atomic_signal_fence(__ATOMIC_RELEASE)
+#else
+#define F_PUBLISH() ((void) 0)
+#endif
+
+#ifndef F_OUT_SIZE
+#define F_OUT_SIZE (1 << 16)
+#endif
+
+#ifndef F_MAX_STACK
 #define F_MAX_STACK 65536
+#endif
+#ifndef F_STACK_INIT
+#define F_STACK_INIT 64
+#endif
+#ifndef F_MAX_LOOP
 #define F_MAX_LOOP 64
+#endif
+#ifndef F_MAX_WORD
 #define F_MAX_WORD 64
-#define F_MAX_EXPR 512
-#define F_MAX_DICT 512
+#endif
+#ifndef F_DICT_INIT
+#define F_DICT_INIT 128
+#endif
+#ifndef F_ARENA_BLOCK
+#define F_ARENA_BLOCK 4096
+#endif
+#ifndef F_MAX_VARS
 #define F_MAX_VARS 512
+#endif
+#ifndef F_MAX_CALLS
+#define F_MAX_CALLS 1048576
+#endif
+#ifndef F_MAX_LOCALS
+#define F_MAX_LOCALS 1048576
+#endif
+#ifndef F_MIN_GUARD
+#define F_MIN_GUARD 3
+#endif
+#ifndef F_JIT_THRESHOLD
+#define F_JIT_THRESHOLD 1000
+#endif
+#ifndef F_INLINE_SIZE
+#define F_INLINE_SIZE 8
+#endif
+#ifndef F_INLINE_DEPTH
+#define F_INLINE_DEPTH 4
+#endif
+#ifndef F_INLINE_BUDGET
+#define F_INLINE_BUDGET 64
+#endif
+#ifndef F_SAMPLE_DEPTH
+#define F_SAMPLE_DEPTH 128
+#endif
+#ifndef F_SAMPLE_SIZE
+#define F_SAMPLE_SIZE (1 << 20)
+#endif
 
 #define F_MSG "Foo, Copyright (C) 2025 CoccusQ.\nInteractive Mode.\nType `bye` to exit"
 
@@ -28,105 +104,700 @@ typedef enum F_Type {
     F_CONTROL,
     F_FUNCTION,
     F_VARIABLE,
-    F_MODULE
+    F_MODULE,
+    F_CONSTANT,
+    F_FCONSTANT
 } F_Type;
 
+#define F_OPS(X) \
+    X(END) X(LIT) X(FLIT) X(STR) X(ERR) X(WORD) X(CALL) X(TAILCALL) X(VAR) X(PRIM) X(CONTROL) \
+    X(JZ) X(JMP) X(UNTIL) X(DEFVAR) X(DEFFVAR) X(DEFCONST) X(DEFFCONST) X(SHOW) \
+    X(VFETCH) X(VSTORE) X(VINC) X(VDEC) X(VADDSTORE) X(VSUBSTORE) X(FVFETCH) X(FVSTORE) \
+    X(LITVSTORE) X(DUPVSTORE) X(ADDLIT) X(SUBLIT) X(MULLIT) \
+    X(GTLIT) X(LTLIT) X(GELIT) X(LELIT) X(EQLIT) X(NELIT) \
+    X(JNGT) X(JNLT) X(JNGE) X(JNLE) X(JNEQ) X(JNNE) \
+    X(VADD) X(VSUB) X(VMUL) X(SQUARE) X(NIP) X(GUARD) \
+    X(LGET) X(LSET) X(FLGET) X(FLSET) X(LADD) X(LSUB) X(LMUL) X(DUPLSET) X(LITLSET) \
+    X(PCALL) X(PTAILCALL) X(PEND) X(PPRIM) X(PCONTROL) X(JIT)
+
+#define F_INLINE_BUILTINS(X) \
+    X(ADD, F_add) X(SUB, F_sub) X(MUL, F_mul) X(DIV, F_div) X(MOD, F_mod) \
+    X(GT, F_greater) X(LT, F_less) X(GE, F_greater_equal) X(LE, F_less_equal) \
+    X(EQ, F_equal) X(NE, F_not_equal) \
+    X(DROP, F_pop_silent) X(DUP, F_dup) X(SWAP, F_swap) X(DEPTH, F_depth) \
+    X(FETCH, F_fetch) X(STORE, F_store) X(INC, F_increase) X(DEC, F_decrease) \
+    X(ADDSTORE, F_add_store) X(SUBSTORE, F_sub_store) X(MULSTORE, F_mul_store) X(DIVSTORE, F_div_store) \
+    X(FADD, F_fadd) X(FSUB, F_fsub) X(FMUL, F_fmul) X(FDIV, F_fdiv) X(FMOD, F_fmod) \
+    X(FGT, F_fgreater) X(FLT, F_fless) X(FGE, F_fgreater_equal) X(FLE, F_fless_equal) \
+    X(FEQ, F_fequal) X(FNE, F_fnot_equal) \
+    X(FDROP, F_fpop_silent) X(FDUP, F_fdup) X(FSWAP, F_fswap) X(FDEPTH, F_fdepth) \
+    X(FFETCH, F_ffetch) X(FSTORE, F_fstore) \
+    X(FADDSTORE, F_fadd_store) X(FSUBSTORE, F_fsub_store) X(FMULSTORE, F_fmul_store) X(FDIVSTORE, F_fdiv_store) \
+    X(FTOI, F_ftoi) X(ITOF, F_itof)
+
+#define F_CALL_BUILTINS(X) \
+    X(DOT, F_pop_stack) X(DOTS, F_print_stack) X(PICK, F_pick) X(PICKSET, F_pick_set) X(QUERY, F_query) \
+    X(EMIT, F_emit) X(CR, F_cr) X(SPACE, F_space) X(TAB, F_tab) \
+    X(GETI, F_geti) X(GETF, F_getf) X(GETC, F_getc) X(BYE, F_bye) \
+    X(FDOT, F_fpop_stack) X(FDOTS, F_fprint_stack) X(FPICK, F_fpick) X(FPICKSET, F_fpick_set) X(FQUERY, F_fquery) \
+    X(SQRT, F_sqrt) X(SIN, F_sin) X(COS, F_cos) X(TAN, F_tan) X(CEIL, F_ceil) X(FLOOR, F_floor) \
+    X(FABS, F_fabs) X(LOG, F_log) X(LOG10, F_log10) X(POW, F_pow)
+
+#define F_BUILTINS(X) F_INLINE_BUILTINS(X) F_CALL_BUILTINS(X)
+
+#define F_GUARDED(X) \
+    X(LIT) X(FLIT) X(VAR) X(JZ) X(UNTIL) \
+    X(ADD) X(SUB) X(MUL) X(DIV) X(MOD) X(GT) X(LT) X(GE) X(LE) X(EQ) X(NE) \
+    X(DROP) X(DUP) X(SWAP) X(DEPTH) X(FETCH) X(STORE) X(INC) X(DEC) \
+    X(ADDSTORE) X(SUBSTORE) X(MULSTORE) X(DIVSTORE) \
+    X(FADD) X(FSUB) X(FMUL) X(FDIV) X(FMOD) X(FGT) X(FLT) X(FGE) X(FLE) X(FEQ) X(FNE) \
+    X(FDROP) X(FDUP) X(FSWAP) X(FDEPTH) X(FFETCH) X(FSTORE) \
+    X(FADDSTORE) X(FSUBSTORE) X(FMULSTORE) X(FDIVSTORE) X(FTOI) X(ITOF) \
+    X(VFETCH) X(VSTORE) X(VINC) X(VDEC) X(VADDSTORE) X(VSUBSTORE) X(FVFETCH) X(FVSTORE) \
+    X(LITVSTORE) X(DUPVSTORE) X(ADDLIT) X(SUBLIT) X(MULLIT) \
+    X(GTLIT) X(LTLIT) X(GELIT) X(LELIT) X(EQLIT) X(NELIT) \
+    X(JNGT) X(JNLT) X(JNGE) X(JNLE) X(JNEQ) X(JNNE) \
+    X(VADD) X(VSUB) X(VMUL) X(SQUARE) X(NIP) \
+    X(LGET) X(LSET) X(FLGET) X(FLSET) X(LADD) X(LSUB) X(LMUL) X(DUPLSET)
+
+typedef enum F_Op {
+#define F_OP_ENUM(op) F_OP_##op,
+    F_OPS(F_OP_ENUM)
+#undef F_OP_ENUM
+#define F_OP_ENUM(op, func) F_OP_##op,
+    F_BUILTINS(F_OP_ENUM)
+#undef F_OP_ENUM
+#define F_OP_ENUM(op) F_OP_U_##op,
+    F_GUARDED(F_OP_ENUM)
+#undef F_OP_ENUM
+    F_OP_COUNT
+} F_Op;
+
+const char *F_opNames[] = {
+#define F_OP_NAME(op) #op,
+    F_OPS(F_OP_NAME)
+#undef F_OP_NAME
+#define F_OP_NAME(op, func) #op,
+    F_BUILTINS(F_OP_NAME)
+#undef F_OP_NAME
+#define F_OP_NAME(op) "U_" #op,
+    F_GUARDED(F_OP_NAME)
+#undef F_OP_NAME
+};
+
+typedef enum F_EffectKind {
+    F_EFFECT_UNKNOWN,
+    F_EFFECT_KNOWN,
+    F_EFFECT_GUARD
+} F_EffectKind;
+
+typedef struct F_Effect {
+    int kind;
+    int dneed, dpeak, dnet;
+    int fneed, fpeak, fnet;
+} F_Effect;
+
 typedef struct F_State F_State;
 
+typedef struct F_Inst {
+    int op;
+    int a;
+    int b;
+} F_Inst;
+
+typedef struct F_Jit {
+    int (*fn)(F_State *state, int start);
+    void *mem;
+    size_t len;
+    F_Inst *inst;
+} F_Jit;
+
+typedef struct F_Code {
+    F_Inst *inst;
+    int size;
+    int capacity;
+    double *fconst;
+    int fconst_size;
+    int fconst_capacity;
+    char *pool;
+    int pool_size;
+    int pool_capacity;
+    const char *src;
+    int version;
+    F_Effect effect;
+    F_Effect prefix;
+    F_Effect *guard;
+    int guard_size;
+    int locals;
+    int shared;
+    unsigned int calls;
+    F_Jit *jit;
+    int *refs;
+    int ref_size;
+    struct F_Code *next;
+} F_Code;
+
 typedef struct F_DictEntry {
-    char word[F_MAX_WORD];
+    const char *word;
     union {
-        char expr[F_MAX_EXPR];
+        const char *expr;
         void (*func)(F_State *);
         void (*control)(F_State *, const char *, int *);
         int var_index;
+        int value;
+        double fvalue;
     };
     F_Type type;
+    F_Code *code;
+    F_Effect effect;
+    int stale;
+    int inlined;
 } F_DictEntry;
 
+typedef struct F_Source {
+    char *data;
+    size_t size;
+    size_t pos;
+    size_t cap;
+    int mapped;
+    FILE *file;
+} F_Source;
+
+typedef struct F_Arena {
+    struct F_Arena *next;
+    size_t size;
+    size_t cap;
+    char data[];
+} F_Arena;
+
+typedef struct F_Users {
+    int *idx;
+    int size;
+    int capacity;
+} F_Users;
+
 typedef struct F_Dict {
+    const struct F_Dict *base;
     F_DictEntry *entry;
+    int capacity;
+    F_Arena *arena;
+    int *index;
+    int index_cap;
     int *vars;
     int var_size;
     double *fvars;
     int fvar_size;
     int size;
+    int version;
+    F_Code *retired;
+    F_Source image;
+    F_Code *image_code;
+    F_Source *modules;
+    int module_count;
+    const char **pending;
+    int pending_cap;
+    F_Users *users;
+    int users_cap;
+    F_Users unresolved;
 } F_Dict;
 
 typedef struct F_Stack {
     int *stack;
     int capacity;
     int size;
+    int max;
 } F_Stack;
 
 typedef struct F_FStack {
     double *stack;
     int capacity;
     int size;
+    int max;
 } F_FStack;
 
+typedef struct F_Frame {
+    F_Code *code;
+    F_Inst *pc;
+    F_Code *owned;
+    int entry;
+    int ltop;
+    int lframe;
+} F_Frame;
+
+typedef struct F_RStack {
+    F_Frame *frame;
+    int capacity;
+    int size;
+    int max;
+    volatile int busy;
+} F_RStack;
+
+typedef union F_Local {
+    int i;
+    double f;
+} F_Local;
+
+typedef struct F_LStack {
+    F_Local *slot;
+    F_Local *frame;
+    int capacity;
+    int size;
+    int max;
+} F_LStack;
+
+typedef void (*F_Sink)(void *ctx, const char *buf, size_t len);
+
+typedef struct F_Dep {
+    int idx;
+    int type;
+    int ival;
+    int name;
+    double fval;
+    F_Effect effect;
+    int inlined;
+} F_Dep;
+
+typedef struct F_DepList {
+    F_Dep *dep;
+    int size;
+    int capacity;
+} F_DepList;
+
+#define F_PROFILE_TABLE 0
+#define F_PROFILE_CSV 1
+#define F_PROFILE_JSON 2
+
+typedef struct F_ProfEntry {
+    uint64_t calls;
+    uint64_t incl;
+    uint64_t excl;
+    int active;
+} F_ProfEntry;
+
+typedef struct F_ProfFrame {
+    int idx;
+    int level;
+    int depth;
+    uint64_t start;
+    uint64_t child;
+} F_ProfFrame;
+
+typedef struct F_Profile {
+    F_ProfEntry *entry;
+    int capacity;
+    F_ProfFrame *frame;
+    int size;
+    int frame_cap;
+    int running;
+    uint64_t ticks;
+    uint64_t ns;
+    uint64_t start_ticks;
+    uint64_t start_ns;
+} F_Profile;
+
+typedef struct F_Sampler {
+    int *buf;
+    int size;
+    int *slot;
+    int slot_cap;
+    int count;
+    volatile int running;
+    volatile int dropped;
+#ifdef F_UNIX
+    struct sigaction old;
+#endif
+} F_Sampler;
+
 struct F_State {
     F_Dict *dict;
     F_Stack *data;
     F_FStack *fdata;
     F_Stack *loop;
+    F_RStack ret;
+    F_LStack locals;
     FILE *input;
-    char line_buf[F_MAX_EXPR * 2];
-    char module_buf[F_MAX_EXPR * 2];
+    F_Source source;
+    char *line;
+    char *out;
+    size_t out_size;
+    F_Sink sink;
+    void *sink_ctx;
+    char *path;
+    int module_cache;
+    int lazy;
+    int deferred;
+    int materialized;
+    int redefined;
+    int relinked;
+    int invalidated;
+    int recompiled;
+    F_DepList *deps;
+    F_Profile *profile;
+    F_Sampler *sampler;
     char word_buf[F_MAX_WORD];
-    char expr_buf[F_MAX_EXPR];
     int line_count;
     int running;
     int interactive;
+    int depth;
+    int peephole;
+    int fused[F_OP_COUNT];
+    int folded;
+    int guard;
+    int jit;
+    unsigned int jit_threshold;
+    int jitted;
+    int inlining;
+    int inlined;
+    int compiling;
+    long long steps;
 };
 
+void F_stdoutSink(void *ctx, const char *buf, size_t len) {
+    (void) ctx;
+    fwrite(buf, 1, len, stdout);
+    fflush(stdout);
+}
+
+#ifdef F_UNIX
+void F_fdSink(void *ctx, const char *buf, size_t len) {
+    int fd = (int) (intptr_t) ctx;
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        buf += n;
+        len -= (size_t) n;
+    }
+}
+#endif
+
+void F_flush(F_State *state) {
+    if (!state->out_size) return;
+    state->sink(state->sink_ctx, state->out, state->out_size);
+    state->out_size = 0;
+}
+
+void F_setSink(F_State *state, F_Sink sink, void *ctx) {
+    F_flush(state);
+    state->sink = sink ? sink : F_stdoutSink;
+    state->sink_ctx = ctx;
+}
+
+static inline char *F_reserve(F_State *state, size_t n) {
+    if (state->out_size + n > F_OUT_SIZE) F_flush(state);
+    return state->out + state->out_size;
+}
+
+void F_putc(F_State *state, int c) {
+    F_reserve(state, 1)[0] = (char) c;
+    state->out_size++;
+}
+
+void F_puts(F_State *state, const char *s) {
+    size_t len = strlen(s);
+    if (len > F_OUT_SIZE) {
+        F_flush(state);
+        state->sink(state->sink_ctx, s, len);
+        return;
+    }
+    memcpy(F_reserve(state, len), s, len);
+    state->out_size += len;
+}
+
+static inline int F_formatUInt(char *p, unsigned long long x) {
+    char tmp[20];
+    int n = 0, len = 0;
+    do {
+        tmp[n++] = (char) ('0' + x % 10);
+        x /= 10;
+    } while (x);
+    while (n) p[len++] = tmp[--n];
+    return len;
+}
+
+void F_putInt(F_State *state, int x) {
+    char *p = F_reserve(state, 12);
+    int len = 0;
+    if (x < 0) p[len++] = '-';
+    len += F_formatUInt(p + len, x < 0 ? 0u - (unsigned) x : (unsigned) x);
+    state->out_size += len;
+}
+
+void F_putFloat(F_State *state, double x) {
+    double a = fabs(x);
+    if (a < 1e15) {
+        unsigned long long ip = (unsigned long long) a;
+        double y = (a - (double) ip) * 1e6;
+        double r = floor(y + 0.5);
+        if (fabs(y - r) < 0.5 - 1e-7) {
+            unsigned long long frac = (unsigned long long) r;
+            if (frac == 1000000) {
+                ip++;
+                frac = 0;
+            }
+            char *p = F_reserve(state, 32);
+            int len = 0;
+            if (signbit(x)) p[len++] = '-';
+            len += F_formatUInt(p + len, ip);
+            p[len++] = '.';
+            for (int i = 6; i > 0; i--, frac /= 10)
+                p[len + i - 1] = (char) ('0' + frac % 10);
+            state->out_size += len + 6;
+            return;
+        }
+    }
+    char *p = F_reserve(state, 320);
+    state->out_size += snprintf(p, 320, "%f", x);
+}
+
 F_Dict *F_createDict() {
     F_Dict *dict = (F_Dict *) malloc(sizeof(F_Dict));
-    dict->entry = (F_DictEntry *) calloc(F_MAX_DICT, sizeof(F_DictEntry));
+    dict->base = NULL;
+    dict->capacity = F_DICT_INIT;
+    dict->entry = (F_DictEntry *) malloc(dict->capacity * sizeof(F_DictEntry));
+    dict->arena = NULL;
+    dict->index_cap = 16;
+    while (dict->index_cap < F_DICT_INIT * 2) dict->index_cap <<= 1;
+    dict->index = (int *) malloc(dict->index_cap * sizeof(int));
+    memset(dict->index, -1, dict->index_cap * sizeof(int));
     dict->vars = (int *) calloc(F_MAX_VARS, sizeof(int));
     dict->var_size = 0;
     dict->fvars = (double *) calloc(F_MAX_VARS, sizeof(double));
     dict->fvar_size = 0;
     dict->size = 0;
+    dict->version = 0;
+    dict->retired = NULL;
+    memset(&dict->image, 0, sizeof(F_Source));
+    dict->image_code = NULL;
+    dict->modules = NULL;
+    dict->module_count = 0;
+    dict->pending = NULL;
+    dict->pending_cap = 0;
+    dict->users = NULL;
+    dict->users_cap = 0;
+    memset(&dict->unresolved, 0, sizeof(F_Users));
+    return dict;
+}
+
+void F_copyUsers(F_Users *to, const F_Users *from) {
+    to->size = to->capacity = from->size;
+    to->idx = from->size ? (int *) malloc(from->size * sizeof(int)) : NULL;
+    if (from->size) memcpy(to->idx, from->idx, from->size * sizeof(int));
+}
+
+F_Dict *F_cloneDict(const F_Dict *base) {
+    F_Dict *dict = (F_Dict *) malloc(sizeof(F_Dict));
+    *dict = *base;
+    dict->base = base;
+    dict->entry = (F_DictEntry *) malloc(dict->capacity * sizeof(F_DictEntry));
+    memcpy(dict->entry, base->entry, base->size * sizeof(F_DictEntry));
+    dict->arena = NULL;
+    dict->vars = (int *) calloc(F_MAX_VARS, sizeof(int));
+    memcpy(dict->vars, base->vars, base->var_size * sizeof(int));
+    dict->fvars = (double *) calloc(F_MAX_VARS, sizeof(double));
+    memcpy(dict->fvars, base->fvars, base->fvar_size * sizeof(double));
+    dict->retired = NULL;
+    memset(&dict->image, 0, sizeof(F_Source));
+    dict->image_code = NULL;
+    dict->modules = NULL;
+    dict->module_count = 0;
+    dict->pending = NULL;
+    dict->pending_cap = 0;
+    dict->users = base->users_cap ? (F_Users *) malloc(base->users_cap * sizeof(F_Users)) : NULL;
+    for (int i = 0; i < base->users_cap; i++) F_copyUsers(&dict->users[i], &base->users[i]);
+    F_copyUsers(&dict->unresolved, &base->unresolved);
     return dict;
 }
 
+void F_freeCode(F_Code *code);
+F_Code *F_build(F_State *state, const char *s);
+void F_closeSource(F_Source *src);
+
+void F_collect(F_Dict *dict) {
+    while (dict->retired) {
+        F_Code *next = dict->retired->next;
+        F_freeCode(dict->retired);
+        dict->retired = next;
+    }
+}
+
+void F_retire(F_Dict *dict, F_Code *code) {
+    if (!code || code->shared) return;
+    code->next = dict->retired;
+    dict->retired = code;
+}
+
 void F_destroyDict(F_Dict *dict) {
+    for (int i = 0; i < dict->size; i++)
+        if (dict->entry[i].type == F_FUNCTION) F_freeCode(dict->entry[i].code);
+    F_collect(dict);
     free(dict->entry);
+    while (dict->arena) {
+        F_Arena *next = dict->arena->next;
+        free(dict->arena);
+        dict->arena = next;
+    }
+    if (!dict->base || dict->index != dict->base->index) free(dict->index);
     free(dict->vars);
     free(dict->fvars);
+    free(dict->image_code);
+    F_closeSource(&dict->image);
+    for (int i = 0; i < dict->module_count; i++) F_closeSource(&dict->modules[i]);
+    free(dict->modules);
+    free(dict->pending);
+    for (int i = 0; i < dict->users_cap; i++) free(dict->users[i].idx);
+    free(dict->users);
+    free(dict->unresolved.idx);
     free(dict);
 }
 
-F_DictEntry *F_find(F_State *state, const char *word) {
-    F_Dict *dict = state->dict;
-    for (int i = 0; i < dict->size; i++) {
-        if (!strcmp(word, dict->entry[i].word))
-            return &dict->entry[i];
+const char *F_arenaDup(F_Dict *dict, const char *s) {
+    size_t len = strlen(s) + 1;
+    F_Arena *a = dict->arena;
+    if (!a || a->cap - a->size < len) {
+        size_t cap = len > F_ARENA_BLOCK ? len : F_ARENA_BLOCK;
+        a = (F_Arena *) malloc(sizeof(F_Arena) + cap);
+        a->size = 0;
+        a->cap = cap;
+        if (dict->arena && len > F_ARENA_BLOCK) {
+            a->next = dict->arena->next;
+            dict->arena->next = a;
+        } else {
+            a->next = dict->arena;
+            dict->arena = a;
+        }
     }
-    return NULL;
+    char *p = a->data + a->size;
+    memcpy(p, s, len);
+    a->size += len;
+    return p;
+}
+
+unsigned int F_hash(const char *word) {
+    unsigned int h = 2166136261u;
+    while (*word) {
+        h ^= (unsigned char)*word++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+int F_lookup(F_Dict *dict, const char *word) {
+    unsigned int mask = dict->index_cap - 1;
+    unsigned int i = F_hash(word) & mask;
+    while (dict->index[i] >= 0) {
+        if (!strcmp(word, dict->entry[dict->index[i]].word))
+            return dict->index[i];
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+void F_insertIndex(F_Dict *dict, int idx) {
+    unsigned int mask = dict->index_cap - 1;
+    unsigned int i = F_hash(dict->entry[idx].word) & mask;
+    while (dict->index[i] >= 0) {
+        if (!strcmp(dict->entry[idx].word, dict->entry[dict->index[i]].word))
+            return;
+        i = (i + 1) & mask;
+    }
+    dict->index[i] = idx;
+}
+
+void F_index(F_Dict *dict, int idx) {
+    if (dict->base && dict->index == dict->base->index) {
+        dict->index = (int *) malloc(dict->index_cap * sizeof(int));
+        memcpy(dict->index, dict->base->index, dict->index_cap * sizeof(int));
+    }
+    if (dict->size * 2 > dict->index_cap) {
+        free(dict->index);
+        dict->index_cap <<= 1;
+        dict->index = (int *) malloc(dict->index_cap * sizeof(int));
+        memset(dict->index, -1, dict->index_cap * sizeof(int));
+        for (int i = 0; i < dict->size; i++)
+            if (i != idx) F_insertIndex(dict, i);
+    }
+    F_insertIndex(dict, idx);
+}
+
+F_DictEntry *F_newEntry(F_Dict *dict, const char *word) {
+    if (dict->size >= dict->capacity) {
+        dict->capacity *= 2;
+        dict->entry = (F_DictEntry *) realloc(dict->entry, dict->capacity * sizeof(F_DictEntry));
+    }
+    F_DictEntry *cur = &dict->entry[dict->size++];
+    memset(cur, 0, sizeof(F_DictEntry));
+    cur->word = F_arenaDup(dict, word);
+    F_index(dict, dict->size - 1);
+    return cur;
+}
+
+F_DictEntry *F_find(F_State *state, const char *word) {
+    int idx = F_lookup(state->dict, word);
+    return idx < 0 ? NULL : &state->dict->entry[idx];
+}
+
+void F_putDef(F_State *state, const char *word, const char *expr) {
+    F_puts(state, ": ");
+    F_puts(state, word);
+    F_puts(state, "\n\t");
+    F_puts(state, expr);
+    F_puts(state, "\n;\n");
+}
+
+void F_putCount(F_State *state, const char *name, int n) {
+    F_puts(state, name);
+    F_putc(state, '\t');
+    F_putInt(state, n);
+    F_putc(state, '\n');
 }
 
 void F_printDict(F_State *state) {
     F_Dict *dict = state->dict;
     for (int i = 0; i < dict->size; i++) {
-        switch (dict->entry[i].type) {
+        F_DictEntry *cur = &dict->entry[i];
+        switch (cur->type) {
             case F_PRIMITIVE:
-                printf("<PRIMITIVE>: %s\n", dict->entry[i].word);
-                break;
             case F_CONTROL:
-                printf("<PRIMITIVE>: %s\n", dict->entry[i].word);
+                F_puts(state, "<PRIMITIVE>: ");
+                F_puts(state, cur->word);
                 break;
             case F_FUNCTION:
-                printf("<FUNCTION>: %s\n\t%s\n;\n", dict->entry[i].word, dict->entry[i].expr);
+                F_puts(state, "<FUNCTION>: ");
+                F_puts(state, cur->word);
+                F_puts(state, "\n\t");
+                F_puts(state, cur->expr);
+                F_puts(state, "\n;");
                 break;
             case F_VARIABLE:
-                printf("<VARIABLE>: %s Address[%d]\n", dict->entry[i].word, dict->entry[i].var_index);
+                F_puts(state, "<VARIABLE>: ");
+                F_puts(state, cur->word);
+                F_puts(state, " Address[");
+                F_putInt(state, cur->var_index);
+                F_putc(state, ']');
                 break;
             case F_MODULE:
-                printf("<MODULE>: %s\n", dict->entry[i].word);
+                F_puts(state, "<MODULE>: ");
+                F_puts(state, cur->word);
+                break;
+            case F_CONSTANT:
+                F_puts(state, "<CONSTANT>: ");
+                F_puts(state, cur->word);
+                F_puts(state, " Value[");
+                F_putInt(state, cur->value);
+                F_putc(state, ']');
+                break;
+            case F_FCONSTANT:
+                F_puts(state, "<CONSTANT>: ");
+                F_puts(state, cur->word);
+                F_puts(state, " Value[");
+                F_putFloat(state, cur->fvalue);
+                F_putc(state, ']');
                 break;
         }
+        F_putc(state, '\n');
     }
 } 
 
@@ -136,120 +807,292 @@ void F_printPrim(F_State *state) {
     for (int i = 0; i < dict->size; i++) {
         switch (dict->entry[i].type) {
             case F_PRIMITIVE:
-                printf("%s\t\t", dict->entry[i].word);
-                cnt++;
-                break;
             case F_CONTROL:
-                printf("%s\t\t", dict->entry[i].word);
+                F_puts(state, dict->entry[i].word);
+                F_puts(state, "\t\t");
                 cnt++;
                 break;
             default:
                 break;
         }
-        if (cnt % 5 == 0) putchar('\n');
+        if (cnt % 5 == 0) F_putc(state, '\n');
     }
-    putchar('\n');
+    F_putc(state, '\n');
 } 
 
 void F_printFunc(F_State *state) {
     F_Dict *dict = state->dict;
-    for (int i = 0; i < dict->size; i++) {
-        switch (dict->entry[i].type) {
-            case F_FUNCTION:
-                printf(": %s\n\t%s\n;\n", dict->entry[i].word, dict->entry[i].expr);
-                break;
-            default:
-                break;
-        }
-    }
+    for (int i = 0; i < dict->size; i++)
+        if (dict->entry[i].type == F_FUNCTION) F_putDef(state, dict->entry[i].word, dict->entry[i].expr);
 } 
 
 void F_printMod(F_State *state) {
     F_Dict *dict = state->dict;
     int cnt = 0;
     for (int i = 0; i < dict->size; i++) {
-        switch (dict->entry[i].type) {
-            case F_MODULE:
-                printf("#%d\t%s\n", cnt, dict->entry[i].word);
-                cnt++;
-                break;
-            default:
-                break;
-        }
+        if (dict->entry[i].type != F_MODULE) continue;
+        F_putc(state, '#');
+        F_putInt(state, cnt++);
+        F_putc(state, '\t');
+        F_puts(state, dict->entry[i].word);
+        F_putc(state, '\n');
     }
 } 
 
 void F_printVar(F_State *state) {
     F_Dict *dict = state->dict;
     for (int i = 0; i < dict->size; i++) {
-        switch (dict->entry[i].type) {
-            case F_VARIABLE:
-                printf("[%d]\t%s\n", dict->entry[i].var_index, dict->entry[i].word);
-                break;
-            default:
-                break;
-        }
+        if (dict->entry[i].type != F_VARIABLE) continue;
+        F_putc(state, '[');
+        F_putInt(state, dict->entry[i].var_index);
+        F_puts(state, "]\t");
+        F_puts(state, dict->entry[i].word);
+        F_putc(state, '\n');
     }
 } 
 
+void F_printFused(F_State *state) {
+    if (state->folded) F_putCount(state, "FOLD", state->folded);
+    if (state->jitted) F_putCount(state, "JIT", state->jitted);
+    if (state->inlined) F_putCount(state, "INLINE", state->inlined);
+    for (int i = 0; i < F_OP_COUNT; i++)
+        if (state->fused[i]) F_putCount(state, F_opNames[i], state->fused[i]);
+}
+
+void F_printLazy(F_State *state) {
+    F_putCount(state, "DEFERRED", state->deferred);
+    F_putCount(state, "MATERIALIZED", state->materialized);
+}
+
+void F_printRedef(F_State *state) {
+    F_putCount(state, "REDEFINED", state->redefined);
+    F_putCount(state, "RELINKED", state->relinked);
+    F_putCount(state, "INVALIDATED", state->invalidated);
+    F_putCount(state, "RECOMPILED", state->recompiled);
+}
+
+void F_showWord(F_State *state, const char *word) {
+    if (!strcmp(word, "*")) F_printDict(state);
+    else if (!strcmp(word, "*p")) F_printPrim(state);
+    else if (!strcmp(word, "*f")) F_printFunc(state);
+    else if (!strcmp(word, "*m")) F_printMod(state);
+    else if (!strcmp(word, "*v")) F_printVar(state);
+    else if (!strcmp(word, "*o")) F_printFused(state);
+    else if (!strcmp(word, "*l")) F_printLazy(state);
+    else if (!strcmp(word, "*r")) F_printRedef(state);
+    else {
+        F_DictEntry *cur = F_find(state, word);
+        if (cur && (cur->type == F_FUNCTION || (cur->type == F_PRIMITIVE && cur->expr)))
+            F_putDef(state, word, cur->expr);
+    }
+}
+
 void F_show(F_State *state, const char *s, int *pos) {
     int i = *pos, word_idx = 0;
     while (s[i] == ' ') i++;
     while (s[i] != ' ' && s[i] != '\0') state->word_buf[word_idx++] = s[i++];
     state->word_buf[word_idx] = '\0';
     *pos = i;
-    if (!strcmp(state->word_buf, "*")) F_printDict(state);
-    else if (!strcmp(state->word_buf, "*p")) F_printPrim(state);
-    else if (!strcmp(state->word_buf, "*f")) F_printFunc(state);
-    else if (!strcmp(state->word_buf, "*m")) F_printMod(state);
-    else if (!strcmp(state->word_buf, "*v")) F_printVar(state);
-    else {
-        F_DictEntry *cur = F_find(state, state->word_buf);
-        if (cur && cur->type == F_FUNCTION) {
-            printf(": %s\n\t%s\n;\n", state->word_buf, cur->expr);
+    F_showWord(state, state->word_buf);
+}
+
+int F_fresh(F_Dict *dict, F_DictEntry *cur) {
+    return cur->code && !cur->stale && cur->code->version == dict->version;
+}
+
+void F_addUser(F_Users *u, int x) {
+    if (u->size >= u->capacity) {
+        u->capacity = u->capacity ? u->capacity * 2 : 4;
+        u->idx = (int *) realloc(u->idx, u->capacity * sizeof(int));
+    }
+    u->idx[u->size++] = x;
+}
+
+int F_hasRef(const F_Code *code, int ref) {
+    for (int i = 0; code && i < code->ref_size; i++)
+        if (code->refs[i] == ref) return 1;
+    return 0;
+}
+
+void F_track(F_Dict *dict, F_DictEntry *cur, const F_Code *old) {
+    F_Code *code = cur->code;
+    int idx = (int) (cur - dict->entry);
+    if (dict->users_cap < dict->size) {
+        dict->users = (F_Users *) realloc(dict->users, dict->capacity * sizeof(F_Users));
+        memset(dict->users + dict->users_cap, 0, (dict->capacity - dict->users_cap) * sizeof(F_Users));
+        dict->users_cap = dict->capacity;
+    }
+    for (int i = 0; i < code->ref_size; i++) {
+        int r = code->refs[i];
+        if (r >= 0) {
+            if (!F_hasRef(old, r)) F_addUser(&dict->users[r], idx);
+            continue;
+        }
+        F_Users *u = &dict->unresolved;
+        int h = (int) F_hash(code->pool - 1 - r), k = 0;
+        while (k < u->size && (u->idx[k] != idx || u->idx[k + 1] != h)) k += 2;
+        if (k < u->size) continue;
+        F_addUser(u, idx);
+        F_addUser(u, h);
+    }
+}
+
+void F_invalidate(F_State *state, int idx) {
+    F_Dict *dict = state->dict;
+    int *stack = NULL, size = 0, cap = 0;
+    for (;;) {
+        F_Users *u = idx < dict->users_cap ? &dict->users[idx] : NULL;
+        for (int i = 0; u && i < u->size; i++) {
+            F_DictEntry *cur = &dict->entry[u->idx[i]];
+            if (cur->type != F_FUNCTION || !F_fresh(dict, cur)) continue;
+            cur->stale = 1;
+            state->invalidated++;
+            if (size >= cap) {
+                cap = cap ? cap * 2 : 16;
+                stack = (int *) realloc(stack, cap * sizeof(int));
+            }
+            stack[size++] = u->idx[i];
+        }
+        if (!size) break;
+        idx = stack[--size];
+    }
+    free(stack);
+}
+
+void F_resolve(F_State *state, const char *word) {
+    F_Dict *dict = state->dict;
+    F_Users *u = &dict->unresolved;
+    int h = (int) F_hash(word), n = 0;
+    for (int i = 0; i < u->size; i += 2) {
+        if (u->idx[i + 1] != h) {
+            u->idx[n++] = u->idx[i];
+            u->idx[n++] = u->idx[i + 1];
+            continue;
+        }
+        F_DictEntry *cur = &dict->entry[u->idx[i]];
+        if (cur->type == F_FUNCTION && F_fresh(dict, cur)) {
+            cur->stale = 1;
+            state->invalidated++;
         }
     }
+    u->size = n;
+}
+
+void F_rebind(F_State *state, F_DictEntry *cur, F_Type type, F_Code *code) {
+    F_Dict *dict = state->dict;
+    int idx = (int) (cur - dict->entry);
+    state->redefined++;
+    if (cur->type == F_FUNCTION && type == F_FUNCTION && !cur->inlined
+        && (!F_fresh(dict, cur) || (code && !memcmp(&code->effect, &cur->code->effect, sizeof(F_Effect)))))
+        state->relinked += idx < dict->users_cap ? dict->users[idx].size : 0;
+    else F_invalidate(state, idx);
+    cur->inlined = 0;
 }
 
 void F_addExpr(F_State *state, const char *word, const char *expr) {
+    int compiling = state->compiling;
+    state->compiling = F_lookup(state->dict, word);
+    F_Code *code = F_build(state, expr);
+    state->compiling = compiling;
+    if (!code) return;
     F_DictEntry *cur = F_find(state, word);
     F_Dict *dict = state->dict;
-    if (!cur) {
-        cur = &dict->entry[dict->size++];
-        strcpy(cur->word, word);
-    } else if (state->interactive)
-        printf("[INFO] Redefined function `%s` at line %d\n", word, state->line_count);
-    strcpy(cur->expr, expr);
+    F_Code *old = NULL;
+    if (!cur) cur = F_newEntry(dict, word);
+    else {
+        int invalidated = state->invalidated;
+        F_rebind(state, cur, F_FUNCTION, code);
+        if (state->interactive) {
+            F_puts(state, "[INFO] Redefined function `");
+            F_puts(state, word);
+            F_puts(state, "` at line ");
+            F_putInt(state, state->line_count);
+            F_puts(state, ", ");
+            F_putInt(state, state->invalidated - invalidated);
+            F_puts(state, " callers invalidated\n");
+        }
+        if (cur->type == F_FUNCTION) {
+            F_retire(dict, cur->code);
+            old = cur->code;
+        }
+    }
+    cur->expr = F_arenaDup(dict, expr);
+    cur->type = F_FUNCTION;
+    cur->code = code;
+    cur->stale = 0;
+    code->src = cur->expr;
+    F_track(dict, cur, old);
+    F_resolve(state, word);
+    if (!state->depth) F_collect(dict);
+}
+
+void F_defer(F_Dict *dict, F_DictEntry *cur, const char *def) {
+    int idx = (int) (cur - dict->entry);
+    if (idx >= dict->pending_cap) {
+        if (!def) return;
+        int cap = dict->capacity;
+        dict->pending = (const char **) realloc(dict->pending, cap * sizeof(char *));
+        memset(dict->pending + dict->pending_cap, 0, (cap - dict->pending_cap) * sizeof(char *));
+        dict->pending_cap = cap;
+    }
+    dict->pending[idx] = def;
+}
+
+void F_addLazy(F_State *state, const char *word, const char *expr) {
+    F_DictEntry *cur = F_find(state, word);
+    F_Dict *dict = state->dict;
+    if (!cur) cur = F_newEntry(dict, word);
+    else {
+        F_rebind(state, cur, F_FUNCTION, NULL);
+        if (cur->type == F_FUNCTION) F_retire(dict, cur->code);
+    }
+    cur->expr = F_arenaDup(dict, expr);
     cur->type = F_FUNCTION;
+    cur->code = NULL;
+    cur->stale = 0;
+    F_defer(dict, cur, NULL);
+    F_resolve(state, word);
+    state->deferred++;
 }
 
 void F_addFunc(F_State *state, const char *word, void (*func)(F_State *)) {
     F_Dict *dict = state->dict;
-    F_DictEntry *cur = &dict->entry[dict->size];
-    strcpy(cur->word, word);
+    F_DictEntry *cur = F_newEntry(dict, word);
     cur->func = func;
     cur->type = F_PRIMITIVE;
-    dict->size++;
+    F_resolve(state, word);
+}
+
+void F_addFuncEffect(F_State *state, const char *word, void (*func)(F_State *),
+                     int din, int dout, int fin, int fout) {
+    F_addFunc(state, word, func);
+    F_Effect *e = &state->dict->entry[state->dict->size - 1].effect;
+    e->kind = F_EFFECT_KNOWN;
+    e->dneed = din;
+    e->dnet = dout - din;
+    e->fneed = fin;
+    e->fnet = fout - fin;
 }
 
 void F_addControl(F_State *state, const char *word, void (*control)(F_State *, const char *, int *)) {
     F_Dict *dict = state->dict;
-    F_DictEntry *cur = &dict->entry[dict->size];
-    strcpy(cur->word, word);
+    F_DictEntry *cur = F_newEntry(dict, word);
     cur->control = control;
     cur->type = F_CONTROL;
-    dict->size++;
+    F_resolve(state, word);
 }
 
 void F_addVar(F_State *state, const char *word, int val) {
     F_Dict *dict = state->dict;
     F_DictEntry *cur = F_find(state, word);
     if (!cur) {
-        cur = &dict->entry[dict->size++];
-        strcpy(cur->word, word);
+        cur = F_newEntry(dict, word);
         cur->var_index = dict->var_size++;
         cur->type = F_VARIABLE;
+        F_resolve(state, word);
     } else if (cur->type != F_VARIABLE) {
+        F_rebind(state, cur, F_VARIABLE, NULL);
+        if (cur->type == F_FUNCTION) F_retire(dict, cur->code);
         cur->var_index = dict->var_size++;
         cur->type = F_VARIABLE;
     }
@@ -260,34 +1103,72 @@ void F_faddVar(F_State *state, const char *word, double val) {
     F_Dict *dict = state->dict;
     F_DictEntry *cur = F_find(state, word);
     if (!cur) {
-        cur = &dict->entry[dict->size++];
-        strcpy(cur->word, word);
+        cur = F_newEntry(dict, word);
         cur->var_index = dict->fvar_size++;
         cur->type = F_VARIABLE;
+        F_resolve(state, word);
     } else if (cur->type != F_VARIABLE) {
+        F_rebind(state, cur, F_VARIABLE, NULL);
+        if (cur->type == F_FUNCTION) F_retire(dict, cur->code);
         cur->var_index = dict->fvar_size++;
         cur->type = F_VARIABLE;
     }
     dict->fvars[cur->var_index] = val;
 }
 
+void F_addConst(F_State *state, const char *word, int val) {
+    F_Dict *dict = state->dict;
+    F_DictEntry *cur = F_find(state, word);
+    if (!cur) {
+        cur = F_newEntry(dict, word);
+        F_resolve(state, word);
+    } else if (cur->type != F_CONSTANT || cur->value != val) {
+        F_rebind(state, cur, F_CONSTANT, NULL);
+        if (cur->type == F_FUNCTION) F_retire(dict, cur->code);
+    }
+    cur->value = val;
+    cur->type = F_CONSTANT;
+}
+
+void F_faddConst(F_State *state, const char *word, double val) {
+    F_Dict *dict = state->dict;
+    F_DictEntry *cur = F_find(state, word);
+    if (!cur) {
+        cur = F_newEntry(dict, word);
+        F_resolve(state, word);
+    } else if (cur->type != F_FCONSTANT || memcmp(&cur->fvalue, &val, sizeof(double))) {
+        F_rebind(state, cur, F_FCONSTANT, NULL);
+        if (cur->type == F_FUNCTION) F_retire(dict, cur->code);
+    }
+    cur->fvalue = val;
+    cur->type = F_FCONSTANT;
+}
+
 void F_addMod(F_State *state, const char *word, int flag) {
     F_Dict *dict = state->dict;
-    F_DictEntry *cur = &dict->entry[dict->size++];
-    strcpy(cur->word, word);
+    F_DictEntry *cur = F_newEntry(dict, word);
     cur->var_index = dict->var_size++;
     cur->type = F_MODULE;
     dict->vars[cur->var_index] = flag;
+    F_resolve(state, word);
 }
 
-F_Stack *F_createStack(int capacity) {
+F_Stack *F_createStack(int max) {
     F_Stack *stk = (F_Stack *) malloc(sizeof(F_Stack));
-    stk->stack = (int *) calloc(capacity, sizeof(int));
-    stk->capacity = capacity;
+    stk->capacity = max < F_STACK_INIT ? max : F_STACK_INIT;
+    stk->stack = (int *) malloc(stk->capacity * sizeof(int));
     stk->size = 0;
+    stk->max = max;
     return stk;
 }
 
+int F_growStack(F_Stack *stk) {
+    if (stk->capacity >= stk->max) return 0;
+    stk->capacity = stk->capacity < stk->max / 2 ? stk->capacity * 2 : stk->max;
+    stk->stack = (int *) realloc(stk->stack, stk->capacity * sizeof(int));
+    return 1;
+}
+
 void F_destroyStack(F_Stack *stk) {
     free(stk->stack);
     free(stk);
@@ -306,7 +1187,7 @@ int F_topValue(F_Stack *stk) {
 }
 
 void F_push(F_State *state, int value) {
-    if (state->data->size >= state->data->capacity) {
+    if (state->data->size >= state->data->capacity && !F_growStack(state->data)) {
         fprintf(stderr, "[ERROR] Stack overflow at line %d\n", state->line_count);
         if (!state->interactive) state->running = 0;
         //else state->data->size = 0;
@@ -343,14 +1224,22 @@ void F_set(F_State *state, int idx, int value) {
     state->data->stack[(state->data->size - idx - 1) % state->data->size] = value;
 }
 
-F_FStack *F_createFStack(int capacity) {
+F_FStack *F_createFStack(int max) {
     F_FStack *stk = (F_FStack *) malloc(sizeof(F_FStack));
-    stk->stack = (double *) calloc(capacity, sizeof(double));
-    stk->capacity = capacity;
+    stk->capacity = max < F_STACK_INIT ? max : F_STACK_INIT;
+    stk->stack = (double *) malloc(stk->capacity * sizeof(double));
     stk->size = 0;
+    stk->max = max;
     return stk;
 }
 
+int F_growFStack(F_FStack *stk) {
+    if (stk->capacity >= stk->max) return 0;
+    stk->capacity = stk->capacity < stk->max / 2 ? stk->capacity * 2 : stk->max;
+    stk->stack = (double *) realloc(stk->stack, stk->capacity * sizeof(double));
+    return 1;
+}
+
 void F_destroyFStack(F_FStack *stk) {
     free(stk->stack);
     free(stk);
@@ -369,7 +1258,7 @@ double F_ftopValue(F_FStack *stk) {
 }
 
 void F_fpush(F_State *state, double value) {
-    if (state->fdata->size >= state->fdata->capacity) {
+    if (state->fdata->size >= state->fdata->capacity && !F_growFStack(state->fdata)) {
         fprintf(stderr, "[ERROR] Stack overflow at line %d\n", state->line_count);
         if (!state->interactive) state->running = 0;
         //else state->fdata->size = 0;
@@ -406,32 +1295,205 @@ void F_fset(F_State *state, int idx, double value) {
     state->fdata->stack[(state->fdata->size - idx - 1) % state->fdata->size] = value;
 }
 
-F_State *F_createState() {
+int F_openSource(F_Source *src, const char *filename) {
+    memset(src, 0, sizeof(F_Source));
+#ifdef F_UNIX
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size > 0) {
+            void *data = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                src->data = (char *) data;
+                src->size = src->cap = (size_t) st.st_size;
+                src->mapped = 1;
+                close(fd);
+                return 0;
+            }
+        }
+    }
+    close(fd);
+#endif
+    FILE *file = fopen(filename, "rb");
+    if (!file) return -1;
+    src->cap = 1 << 16;
+    src->data = (char *) malloc(src->cap);
+    for (size_t n; (n = fread(src->data + src->size, 1, src->cap - src->size, file)) > 0; ) {
+        src->size += n;
+        if (src->size == src->cap)
+            src->data = (char *) realloc(src->data, src->cap *= 2);
+    }
+    fclose(file);
+    return 0;
+}
+
+void F_streamSource(F_Source *src, FILE *file) {
+    memset(src, 0, sizeof(F_Source));
+    src->file = file;
+    src->cap = 1 << 12;
+    src->data = (char *) malloc(src->cap);
+}
+
+static size_t F_fillSource(F_Source *src, size_t start) {
+    if (!src->file) return 0;
+    if (start) {
+        memmove(src->data, src->data + start, src->size - start);
+        src->size -= start;
+    }
+    if (src->cap - src->size < 4096)
+        src->data = (char *) realloc(src->data, src->cap = src->cap * 2 + 4096);
+    if (!fgets(src->data + src->size, (int) (src->cap - src->size), src->file)) return 0;
+    size_t n = strlen(src->data + src->size);
+    src->size += n;
+    return n;
+}
+
+int F_readLine(F_State *state, F_Source *src, char **line) {
+    size_t start = src->pos, len = start, i = start;
+    int comment = 0;
+    char *p = src->data;
+    if (i < src->size) {
+        char *nl = (char *) memchr(p + i, '\n', src->size - i);
+        size_t end = nl ? (size_t) (nl - p) : src->size;
+        if (nl && !memchr(p + i, '\\', end - i) && !memchr(p + i, '\r', end - i)) {
+            *nl = '\0';
+            src->pos = end + 1;
+            *line = p + start;
+            return '\n';
+        }
+    }
+    for (;;) {
+        for (; i < src->size; i++) {
+            char c = p[i];
+            if (c == '\\') {
+                comment = 1;
+                state->line_count++;
+            } else if (c == '\n' || c == '\r') {
+                if (comment) comment = 0;
+                else {
+                    p[len] = '\0';
+                    src->pos = i + 1;
+                    *line = p + start;
+                    return c;
+                }
+            } else if (!comment) p[len++] = c;
+        }
+        size_t shift = start;
+        if (!F_fillSource(src, start)) break;
+        p = src->data;
+        start = 0;
+        len -= shift;
+        i -= shift;
+    }
+    src->pos = src->size;
+    return EOF;
+}
+
+void F_closeSource(F_Source *src) {
+#ifdef F_UNIX
+    if (src->mapped) munmap(src->data, src->size);
+    else free(src->data);
+#else
+    free(src->data);
+#endif
+    memset(src, 0, sizeof(F_Source));
+}
+
+static F_State *F_newState(F_Dict *dict) {
     F_State *state = (F_State *) malloc(sizeof(F_State));
-    state->dict = F_createDict();
+    state->dict = dict;
     state->data = F_createStack(F_MAX_STACK);
     state->fdata = F_createFStack(F_MAX_STACK);
     state->loop = F_createStack(F_MAX_LOOP);
+    state->ret.capacity = 64;
+    state->ret.frame = (F_Frame *) malloc(state->ret.capacity * sizeof(F_Frame));
+    state->ret.frame[0].entry = -1;
+    state->ret.size = 0;
+    state->ret.max = F_MAX_CALLS;
+    state->ret.busy = 0;
+    state->locals.capacity = 64;
+    state->locals.slot = (F_Local *) malloc(state->locals.capacity * sizeof(F_Local));
+    state->locals.frame = state->locals.slot;
+    state->locals.size = 0;
+    state->locals.max = F_MAX_LOCALS;
     state->input = stdin;
+    memset(&state->source, 0, sizeof(F_Source));
+    state->line = NULL;
     state->line_count = 0;
     state->running = 1;
     state->interactive = 1;
+    state->depth = 0;
+    state->peephole = 1;
+    memset(state->fused, 0, sizeof(state->fused));
+    state->folded = 0;
+    state->guard = 1;
+    state->jit = 1;
+    state->jit_threshold = F_JIT_THRESHOLD;
+    state->jitted = 0;
+    state->inlining = 1;
+    state->inlined = 0;
+    state->compiling = -1;
+    state->steps = 0;
+    state->out = (char *) malloc(F_OUT_SIZE);
+    state->out_size = 0;
+    state->sink = F_stdoutSink;
+    state->sink_ctx = NULL;
+    state->path = NULL;
+    state->module_cache = 1;
+    state->lazy = 1;
+    state->deferred = 0;
+    state->materialized = 0;
+    state->redefined = 0;
+    state->relinked = 0;
+    state->invalidated = 0;
+    state->recompiled = 0;
+    state->deps = NULL;
+    state->profile = NULL;
+    state->sampler = NULL;
     return state;
 }
 
+F_State *F_createState() {
+    return F_newState(F_createDict());
+}
+
+F_State *F_createStateFrom(const F_Dict *base) {
+    return F_newState(F_cloneDict(base));
+}
+
+void F_sampleStop(F_State *state);
+
 void F_destroyState(F_State *state) {
+    F_flush(state);
+    free(state->out);
+    free(state->path);
+    if (state->profile) {
+        free(state->profile->entry);
+        free(state->profile->frame);
+        free(state->profile);
+    }
+    if (state->sampler) {
+        F_sampleStop(state);
+        free(state->sampler->buf);
+        free(state->sampler->slot);
+        free(state->sampler);
+    }
     F_destroyDict(state->dict);
     F_destroyStack(state->data);
     F_destroyFStack(state->fdata);
     F_destroyStack(state->loop);
+    free(state->ret.frame);
+    free(state->locals.slot);
+    F_closeSource(&state->source);
     if (state->input != stdin) fclose(state->input);
     free(state);
 }
 
 void F_eval(F_State *state, char *s);
+void F_execEntry(F_State *state, F_DictEntry *cur);
 
-void F_parseNum(F_State *state, const char *str, int *pos) {
-    if (!state->running) return;
+int F_scanNum(const char *str, int *pos, int *ival, double *fval) {
     int x = 0, f = 1;
     double fractional = 0.0, divisor = 10.0;
     char c = str[*pos];
@@ -452,28 +1514,47 @@ void F_parseNum(F_State *state, const char *str, int *pos) {
         }
     }
     if (divisor == 10.0) {
-        F_push(state, x * f);
-    } else {
-        F_fpush(state, (x + fractional) * f);
+        *ival = x * f;
+        return 0;
     }
+    *fval = (x + fractional) * f;
+    return 1;
 }
-void F_parseChar(F_State *state, const char *str, int *pos) {
+
+void F_parseNum(F_State *state, const char *str, int *pos) {
     if (!state->running) return;
+    int x;
+    double fx;
+    if (F_scanNum(str, pos, &x, &fx)) F_fpush(state, fx);
+    else F_push(state, x);
+}
+
+const char *F_scanError[] = {
+    NULL,
+    "Unterminated character literal",
+    "Expected closing quote",
+    "Unmatched `until`"
+};
+
+int F_scanChar(const char *str, int *pos, int *c) {
     (*pos)++;
-    if (str[*pos] == '\0') {
-        fprintf(stderr, "[ERROR] Unterminated character literal at line %d\n", state->line_count);
-        if (!state->interactive) state->running = 0;
-        return;
-    }
-    int c = (int)str[(*pos)++];
-    if (str[*pos] != '\'') {
-        fprintf(stderr, "[ERROR] Expected closing quote at line %d\n", state->line_count);
+    if (str[*pos] == '\0') return 1;
+    *c = (int)str[(*pos)++];
+    if (str[*pos] != '\'') return 2;
+    (*pos)++;
+    while (str[*pos] == ' ') (*pos)++;
+    return 0;
+}
+
+void F_parseChar(F_State *state, const char *str, int *pos) {
+    if (!state->running) return;
+    int c, err = F_scanChar(str, pos, &c);
+    if (err) {
+        fprintf(stderr, "[ERROR] %s at line %d\n", F_scanError[err], state->line_count);
         if (!state->interactive) state->running = 0;
         return;
     }
-    (*pos)++;
     F_push(state, c);
-    while (str[*pos] == ' ') (*pos)++;
 }
 
 void F_parseString(F_State *state, const char *str, int *pos) {
@@ -486,96 +1567,821 @@ void F_parseString(F_State *state, const char *str, int *pos) {
     (*pos)++;
 }
 
+void F_pushString(F_State *state, const char *s) {
+    for (; *s; s++) F_push(state, *s);
+    F_push(state, '\0');
+}
+
 void F_parseWord(F_State *state, const char *str, int *pos) {
     if (!state->running) return;
     int word_idx = 0;
     while (str[*pos] != ' ' && str[*pos] != '\0')
         state->word_buf[word_idx++] = str[(*pos)++];
     state->word_buf[word_idx] = '\0';
-    for (int i = 0; i < state->dict->size; i++) {
-        if (!strcmp(state->word_buf, state->dict->entry[i].word)) {
-            switch (state->dict->entry[i].type) {
-                case F_MODULE:
-                    F_push(state, state->dict->entry[i].var_index);
-                    break;
-                case F_VARIABLE:
-                    F_push(state, state->dict->entry[i].var_index);
-                    break;
-                case F_FUNCTION:
-                    F_eval(state, state->dict->entry[i].expr);
-                    break;
-                case F_PRIMITIVE:
-                    if (state->dict->entry[i].func)
-                        state->dict->entry[i].func(state);
-                    break;
-                case F_CONTROL:
-                    if (state->dict->entry[i].control)
-                        state->dict->entry[i].control(state, str, pos);
-                    break;
-                default:
-                    break;
-            }
-            return;
-        }
+    F_DictEntry *cur = F_find(state, state->word_buf);
+    if (cur) {
+        if (cur->type == F_CONTROL) {
+            if (cur->control)
+                cur->control(state, str, pos);
+        } else F_execEntry(state, cur);
+        return;
     }
     fprintf(stderr, "[ERROR] Undefined word `%s` at line %d\n", state->word_buf, state->line_count);
     if (!state->interactive) state->running = 0;
     //else state->data->size = 0;
 }
 
-void F_eval(F_State *state, char *s) {
-    if (!state->running) return;
-    for (int i = 0; s[i] != '\0';) {
-        if (s[i] == ' ') {
-            i++;
-            continue;
+void F_exec(F_State *state, F_Code *code);
+void F_run(F_State *state, F_Code *code, int entry);
+
+#define F_profiling(state) ((state)->profile && (state)->profile->running)
+
+uint64_t F_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static inline uint64_t F_ticks(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_ia32_rdtsc();
+#else
+    return F_clock();
+#endif
+}
+
+void F_profileEnter(F_State *state, int idx, int level, int depth) {
+    F_Profile *prof = state->profile;
+    if (idx >= prof->capacity) {
+        int cap = state->dict->capacity > idx ? state->dict->capacity : idx + 1;
+        prof->entry = (F_ProfEntry *) realloc(prof->entry, cap * sizeof(F_ProfEntry));
+        memset(prof->entry + prof->capacity, 0, (cap - prof->capacity) * sizeof(F_ProfEntry));
+        prof->capacity = cap;
+    }
+    if (prof->size >= prof->frame_cap) {
+        prof->frame_cap = prof->frame_cap ? prof->frame_cap * 2 : 64;
+        prof->frame = (F_ProfFrame *) realloc(prof->frame, prof->frame_cap * sizeof(F_ProfFrame));
+    }
+    F_ProfFrame *fr = &prof->frame[prof->size++];
+    fr->idx = idx;
+    fr->level = level;
+    fr->depth = depth;
+    fr->child = 0;
+    prof->entry[idx].calls++;
+    prof->entry[idx].active++;
+    fr->start = F_ticks();
+}
+
+void F_profileExit(F_State *state) {
+    uint64_t now = F_ticks();
+    F_Profile *prof = state->profile;
+    if (!prof->size) return;
+    F_ProfFrame *fr = &prof->frame[--prof->size];
+    F_ProfEntry *e = &prof->entry[fr->idx];
+    uint64_t dt = now - fr->start;
+    e->excl += dt - fr->child;
+    if (!--e->active) e->incl += dt;
+    if (prof->size) prof->frame[prof->size - 1].child += dt;
+}
+
+void F_profileLeave(F_State *state, int level, int depth) {
+    F_Profile *prof = state->profile;
+    while (prof->size) {
+        F_ProfFrame *fr = &prof->frame[prof->size - 1];
+        if (fr->level < level || (fr->level == level && fr->depth < depth)) break;
+        F_profileExit(state);
+    }
+}
+
+void F_profileStart(F_State *state) {
+    if (!state->profile) state->profile = (F_Profile *) calloc(1, sizeof(F_Profile));
+    F_Profile *prof = state->profile;
+    if (prof->capacity) memset(prof->entry, 0, prof->capacity * sizeof(F_ProfEntry));
+    prof->size = 0;
+    prof->ticks = prof->ns = 0;
+    prof->running = 1;
+    prof->start_ns = F_clock();
+    prof->start_ticks = F_ticks();
+    state->dict->version++;
+}
+
+void F_profileStop(F_State *state) {
+    F_Profile *prof = state->profile;
+    if (!prof || !prof->running) return;
+    while (prof->size) F_profileExit(state);
+    prof->ticks += F_ticks() - prof->start_ticks;
+    prof->ns += F_clock() - prof->start_ns;
+    prof->running = 0;
+    state->dict->version++;
+}
+
+static const char *F_typeName(int type) {
+    switch (type) {
+        case F_FUNCTION: return "function";
+        case F_PRIMITIVE: return "primitive";
+        case F_CONTROL: return "control";
+        default: return "other";
+    }
+}
+
+void F_profileDump(F_State *state, FILE *out, int format) {
+    F_Profile *prof = state->profile;
+    if (!prof) return;
+    F_flush(state);
+    uint64_t ticks = prof->ticks, ns = prof->ns;
+    if (prof->running) {
+        ticks += F_ticks() - prof->start_ticks;
+        ns += F_clock() - prof->start_ns;
+    }
+    double scale = ticks ? (double) ns / (double) ticks : 1.0;
+    int n = 0, *order = (int *) malloc((prof->capacity + 1) * sizeof(int));
+    for (int i = 0; i < prof->capacity && i < state->dict->size; i++)
+        if (prof->entry[i].calls) order[n++] = i;
+    for (int i = 1; i < n; i++) {
+        int x = order[i], j = i;
+        for (; j > 0 && prof->entry[order[j - 1]].excl < prof->entry[x].excl; j--) order[j] = order[j - 1];
+        order[j] = x;
+    }
+    if (format == F_PROFILE_TABLE)
+        fprintf(out, "%-20s %-10s %12s %12s %12s %7s\n", "word", "type", "calls", "incl(ms)", "excl(ms)", "excl%");
+    else if (format == F_PROFILE_CSV) fprintf(out, "word,type,calls,incl_ns,excl_ns\n");
+    else fprintf(out, "{\"total_ns\": %llu, \"words\": [", (unsigned long long) ns);
+    for (int k = 0; k < n; k++) {
+        F_DictEntry *cur = &state->dict->entry[order[k]];
+        F_ProfEntry *e = &prof->entry[order[k]];
+        double incl = e->incl * scale, excl = e->excl * scale;
+        if (format == F_PROFILE_TABLE)
+            fprintf(out, "%-20s %-10s %12llu %12.3f %12.3f %6.2f%%\n", cur->word, F_typeName(cur->type),
+                    (unsigned long long) e->calls, incl / 1e6, excl / 1e6, ns ? excl * 100.0 / ns : 0.0);
+        else if (format == F_PROFILE_CSV)
+            fprintf(out, "\"%s\",%s,%llu,%.0f,%.0f\n", cur->word, F_typeName(cur->type),
+                    (unsigned long long) e->calls, incl, excl);
+        else {
+            fprintf(out, "%s\n  {\"word\": \"", k ? "," : "");
+            for (const char *c = cur->word; *c; c++) {
+                if (*c == '"' || *c == '\\') fputc('\\', out);
+                fputc(*c, out);
+            }
+            fprintf(out, "\", \"type\": \"%s\", \"calls\": %llu, \"incl_ns\": %.0f, \"excl_ns\": %.0f}",
+                    F_typeName(cur->type), (unsigned long long) e->calls, incl, excl);
         }
-        if (isdigit(s[i]) || (s[i] == '-' && isdigit(s[i + 1]))) F_parseNum(state, s, &i);
-        else if (s[i] == '\'' && isprint(s[i + 1])) F_parseChar(state, s, &i);
-        else if (s[i] == '"') F_parseString(state, s, &i);
-        else F_parseWord(state, s, &i);
     }
+    if (format == F_PROFILE_JSON) fprintf(out, "\n]}\n");
+    free(order);
 }
 
-void F_compile(F_State *state, char *s) {
+#ifdef F_UNIX
+static F_State *volatile F_sampleTarget = NULL;
+
+static void F_sampleSignal(int sig) {
+    (void) sig;
+    F_State *state = F_sampleTarget;
+    if (!state || !state->sampler->running) return;
+    F_Sampler *s = state->sampler;
+    if (state->ret.busy) {
+        s->dropped++;
+        return;
+    }
+    int key[F_SAMPLE_DEPTH + 2], n = F_SAMPLE_DEPTH + 2, i = state->ret.size;
+    F_Frame *frame = state->ret.frame;
+    if (frame[i].entry >= 0) key[--n] = frame[i].entry;
+    while (i > 0 && n > 2)
+        if (frame[--i].entry >= 0) key[--n] = frame[i].entry;
+    while (i > 0 && frame[i - 1].entry < 0) i--;
+    if (i > 0) key[--n] = -2;
+    key[--n] = state->line_count;
+    int len = F_SAMPLE_DEPTH + 2 - n;
+    unsigned int h = 2166136261u;
+    for (int k = n; k < n + len; k++) h = (h ^ (unsigned int) key[k]) * 16777619u;
+    int mask = s->slot_cap - 1, j = (int) (h & mask);
+    for (; s->slot[j]; j = (j + 1) & mask) {
+        int *rec = s->buf + s->slot[j] - 1;
+        if (rec[1] == len && !memcmp(rec + 2, key + n, len * sizeof(int))) {
+            rec[0]++;
+            return;
+        }
+    }
+    if (s->size + len + 2 > F_SAMPLE_SIZE || s->count * 4 >= s->slot_cap * 3) {
+        s->dropped++;
+        return;
+    }
+    int *rec = s->buf + s->size;
+    rec[0] = 1;
+    rec[1] = len;
+    memcpy(rec + 2, key + n, len * sizeof(int));
+    s->slot[j] = s->size + 1;
+    s->size += len + 2;
+    s->count++;
+}
+#endif
+
+int F_sampleStart(F_State *state, int hz) {
+#ifdef F_UNIX
+    if (hz <= 0 || hz > 1000000 || (F_sampleTarget && F_sampleTarget != state)) return -1;
+    if (!state->sampler) {
+        state->sampler = (F_Sampler *) calloc(1, sizeof(F_Sampler));
+        state->sampler->buf = (int *) malloc(F_SAMPLE_SIZE * sizeof(int));
+        state->sampler->slot_cap = F_SAMPLE_SIZE / 16;
+        state->sampler->slot = (int *) malloc(state->sampler->slot_cap * sizeof(int));
+    }
+    F_Sampler *s = state->sampler;
+    if (s->running) F_sampleStop(state);
+    memset(s->slot, 0, s->slot_cap * sizeof(int));
+    s->size = s->count = s->dropped = 0;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = F_sampleSignal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    F_sampleTarget = state;
+    s->running = 1;
+    struct itimerval it;
+    it.it_interval.tv_sec = 0;
+    it.it_interval.tv_usec = 1000000 / hz;
+    it.it_value = it.it_interval;
+    if (sigaction(SIGPROF, &sa, &s->old) < 0 || setitimer(ITIMER_PROF, &it, NULL) < 0) {
+        s->running = 0;
+        F_sampleTarget = NULL;
+        return -1;
+    }
+    return 0;
+#else
+    (void) state;
+    (void) hz;
+    return -1;
+#endif
+}
+
+void F_sampleStop(F_State *state) {
+#ifdef F_UNIX
+    F_Sampler *s = state->sampler;
+    if (!s || !s->running) return;
+    struct itimerval it;
+    memset(&it, 0, sizeof(it));
+    setitimer(ITIMER_PROF, &it, NULL);
+    s->running = 0;
+    sigaction(SIGPROF, &s->old, NULL);
+    F_sampleTarget = NULL;
+#else
+    (void) state;
+#endif
+}
+
+void F_sampleDump(F_State *state, FILE *out) {
+    F_Sampler *s = state->sampler;
+    if (!s) return;
+    F_Dict *dict = state->dict;
+    for (int off = 0; off < s->size; off += s->buf[off + 1] + 2) {
+        int *rec = s->buf + off;
+        fprintf(out, "line:%d", rec[2]);
+        for (int k = 3; k < rec[1] + 2; k++) {
+            if (rec[k] == -2) fputs(";[...]", out);
+            else fprintf(out, ";%s", rec[k] < dict->size ? dict->entry[rec[k]].word : "[?]");
+        }
+        fprintf(out, " %d\n", rec[0]);
+    }
+}
+
+F_Code *F_restore(F_State *state, const char *def);
+int F_jitCode(F_State *state, F_Code *code);
+
+F_Code *F_link(F_State *state, F_DictEntry *cur) {
+    if (!cur->code) {
+        F_Dict *dict = state->dict;
+        int idx = (int) (cur - dict->entry);
+        const char *def = idx < dict->pending_cap ? dict->pending[idx] : NULL;
+        if (def) dict->pending[idx] = NULL;
+        F_Code *code = def && !F_profiling(state) ? F_restore(state, def) : F_build(state, cur->expr);
+        state->materialized++;
+        cur->code = code ? code : F_build(state, "");
+        cur->code->src = cur->expr;
+        F_track(dict, cur, NULL);
+    } else if (cur->stale || cur->code->version != state->dict->version) {
+        F_Code *code = F_build(state, cur->expr);
+        if (code) {
+            F_Code *old = cur->code;
+            F_retire(state->dict, old);
+            cur->code = code;
+            if (cur->stale) state->recompiled++;
+            cur->stale = 0;
+            F_track(state->dict, cur, old);
+        }
+    }
+    if (++cur->code->calls == state->jit_threshold) F_jitCode(state, cur->code);
+    return cur->code;
+}
+
+void F_call(F_State *state, F_DictEntry *cur) {
+    F_run(state, F_link(state, cur), (int) (cur - state->dict->entry));
+}
+
+void F_execEntry(F_State *state, F_DictEntry *cur) {
+    switch (cur->type) {
+        case F_MODULE:
+            F_push(state, cur->var_index);
+            break;
+        case F_VARIABLE:
+            F_push(state, cur->var_index);
+            break;
+        case F_CONSTANT:
+            F_push(state, cur->value);
+            break;
+        case F_FCONSTANT:
+            F_fpush(state, cur->fvalue);
+            break;
+        case F_FUNCTION:
+            if (F_profiling(state))
+                F_profileEnter(state, (int) (cur - state->dict->entry), state->depth + 1, state->ret.size);
+            F_call(state, cur);
+            break;
+        case F_PRIMITIVE:
+            if (!cur->func) break;
+            if (F_profiling(state)) {
+                F_profileEnter(state, (int) (cur - state->dict->entry), state->depth, INT_MAX);
+                cur->func(state);
+                F_profileExit(state);
+            } else cur->func(state);
+            break;
+        default:
+            break;
+    }
+}
+
+F_Dict *F_freezeState(F_State *state) {
+    F_Dict *dict = state->dict;
+    for (int i = 0; i < dict->size; i++) {
+        F_DictEntry *cur = &dict->entry[i];
+        if (cur->type == F_FUNCTION && F_link(state, cur) && !cur->code->shared)
+            cur->code->shared = 1;
+    }
+    F_collect(dict);
+    state->dict = F_createDict();
+    F_destroyState(state);
+    return dict;
+}
+
+void F_destroyBase(F_Dict *base) {
+    for (int i = 0; i < base->size; i++)
+        if (base->entry[i].type == F_FUNCTION && base->entry[i].code && base->entry[i].code->shared == 1)
+            base->entry[i].code->shared = 0;
+    F_destroyDict(base);
+}
+
+#define F_IMAGE_MAGIC "FOOIMG\0\4"
+
+typedef struct F_ImageHeader {
+    char magic[8];
+    int op_count;
+    int inst_size;
+    int dict_size;
+    int dict_version;
+    int var_size;
+    int fvar_size;
+    int data_size;
+    int fdata_size;
+    int code_count;
+    int user_size;
+    uint64_t strings;
+    uint64_t entries;
+    uint64_t codes;
+    uint64_t vars;
+    uint64_t fvars;
+    uint64_t data;
+    uint64_t fdata;
+    uint64_t users;
+    uint64_t size;
+} F_ImageHeader;
+
+typedef struct F_ImageEntry {
+    int type;
+    int code;
+    uint64_t word;
+    uint64_t expr;
+    union {
+        int var_index;
+        int value;
+        double fvalue;
+    };
+    F_Effect effect;
+    int inlined;
+} F_ImageEntry;
+
+typedef struct F_ImageCode {
+    int size;
+    int fconst_size;
+    int pool_size;
+    int guard_size;
+    int locals;
+    int pad;
+    F_Effect effect;
+    F_Effect prefix;
+    uint64_t inst;
+    uint64_t fconst;
+    uint64_t pool;
+    uint64_t guard;
+} F_ImageCode;
+
+static uint64_t F_imageWrite(FILE *f, uint64_t *off, const void *p, size_t n) {
+    static const char zero[8] = {0};
+    uint64_t at = *off;
+    if (n) fwrite(p, 1, n, f);
+    fwrite(zero, 1, (8 - n % 8) % 8, f);
+    *off += (n + 7) / 8 * 8;
+    return at;
+}
+
+int F_saveImage(F_State *state, const char *filename) {
+    F_Dict *dict = state->dict;
+    for (int i = 0; i < dict->size; i++)
+        if (dict->entry[i].type == F_FUNCTION) F_link(state, &dict->entry[i]);
+    FILE *f = fopen(filename, "wb");
+    if (!f) {
+        fprintf(stderr, "[ERROR] Failed to save image `%s`: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    F_ImageHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, F_IMAGE_MAGIC, 8);
+    h.op_count = F_OP_COUNT;
+    h.inst_size = sizeof(F_Inst);
+    h.dict_size = dict->size;
+    h.dict_version = dict->version;
+    h.var_size = dict->var_size;
+    h.fvar_size = dict->fvar_size;
+    h.data_size = state->data->size;
+    h.fdata_size = state->fdata->size;
+    F_ImageEntry *entry = (F_ImageEntry *) calloc(dict->size + 1, sizeof(F_ImageEntry));
+    F_ImageCode *code = (F_ImageCode *) calloc(dict->size + 1, sizeof(F_ImageCode));
+    uint64_t off = 0;
+    F_imageWrite(f, &off, &h, sizeof(h));
+    h.strings = off;
+    for (int i = 0; i < dict->size; i++) {
+        F_DictEntry *cur = &dict->entry[i];
+        entry[i].type = cur->type;
+        entry[i].code = -1;
+        entry[i].effect = cur->effect;
+        entry[i].inlined = cur->inlined;
+        entry[i].word = F_imageWrite(f, &off, cur->word, strlen(cur->word) + 1) - h.strings;
+        if (cur->type == F_FUNCTION) {
+            entry[i].expr = F_imageWrite(f, &off, cur->expr, strlen(cur->expr) + 1) - h.strings;
+            entry[i].code = h.code_count++;
+        } else if (cur->type == F_FCONSTANT) entry[i].fvalue = cur->fvalue;
+        else if (cur->type == F_CONSTANT) entry[i].value = cur->value;
+        else entry[i].var_index = cur->var_index;
+    }
+    for (int i = 0; i < dict->size; i++) {
+        if (entry[i].code < 0) continue;
+        F_Code *c = dict->entry[i].code;
+        F_ImageCode *ic = &code[entry[i].code];
+        ic->size = c->size;
+        ic->fconst_size = c->fconst_size;
+        ic->pool_size = c->pool_size;
+        ic->guard_size = c->guard_size;
+        ic->locals = c->locals;
+        ic->effect = c->effect;
+        ic->prefix = c->prefix;
+        F_Inst *inst = c->inst;
+        if (c->jit) {
+            inst = (F_Inst *) malloc(c->size * sizeof(F_Inst));
+            memcpy(inst, c->inst, c->size * sizeof(F_Inst));
+            inst[0] = c->jit->inst[1];
+        }
+        ic->inst = F_imageWrite(f, &off, inst, c->size * sizeof(F_Inst));
+        if (inst != c->inst) free(inst);
+        ic->fconst = F_imageWrite(f, &off, c->fconst, c->fconst_size * sizeof(double));
+        ic->pool = F_imageWrite(f, &off, c->pool, c->pool_size);
+        ic->guard = F_imageWrite(f, &off, c->guard, c->guard_size * sizeof(F_Effect));
+    }
+    h.entries = F_imageWrite(f, &off, entry, dict->size * sizeof(F_ImageEntry));
+    h.codes = F_imageWrite(f, &off, code, h.code_count * sizeof(F_ImageCode));
+    h.vars = F_imageWrite(f, &off, dict->vars, dict->var_size * sizeof(int));
+    h.fvars = F_imageWrite(f, &off, dict->fvars, dict->fvar_size * sizeof(double));
+    h.data = F_imageWrite(f, &off, state->data->stack, state->data->size * sizeof(int));
+    h.fdata = F_imageWrite(f, &off, state->fdata->stack, state->fdata->size * sizeof(double));
+    int total = dict->size + 1 + dict->unresolved.size;
+    for (int i = 0; i < dict->size && i < dict->users_cap; i++) total += dict->users[i].size;
+    int *users = (int *) malloc(total * sizeof(int));
+    for (int i = 0; i <= dict->size; i++) {
+        F_Users *u = i == dict->size ? &dict->unresolved : i < dict->users_cap ? &dict->users[i] : NULL;
+        int n = u ? u->size : 0;
+        users[h.user_size++] = n;
+        if (n) memcpy(users + h.user_size, u->idx, n * sizeof(int));
+        h.user_size += n;
+    }
+    h.users = F_imageWrite(f, &off, users, h.user_size * sizeof(int));
+    free(users);
+    h.size = off;
+    rewind(f);
+    fwrite(&h, 1, sizeof(h), f);
+    free(entry);
+    free(code);
+    if (fclose(f) != 0) {
+        fprintf(stderr, "[ERROR] Failed to save image `%s`: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int *F_jumpTarget(F_Inst *p);
+int F_checkedOp(int op);
+F_Effect F_opEffect(int op);
+
+static int F_imageSpan(const F_ImageHeader *h, uint64_t off, int count, size_t elem) {
+    return count >= 0 && off <= h->size && off % 8 == 0 && (uint64_t) count <= (h->size - off) / elem;
+}
+
+static int F_imageString(const char *data, const F_ImageHeader *h, uint64_t off) {
+    return off < h->size - h->strings && memchr(data + h->strings + off, '\0', h->size - h->strings - off);
+}
+
+static int F_instEntry(const F_Inst *p, int *type) {
+    switch (F_checkedOp(p->op)) {
+        case F_OP_CALL: case F_OP_TAILCALL: case F_OP_PCALL: case F_OP_PTAILCALL:
+            *type = -1;
+            return 1;
+        case F_OP_PRIM: case F_OP_PPRIM:
+            *type = F_PRIMITIVE;
+            return 1;
+        case F_OP_CONTROL: case F_OP_PCONTROL:
+            *type = F_CONTROL;
+            return 1;
+    }
+    return 0;
+}
+
+static int F_checkInst(const F_ImageCode *ic, F_Inst *p, int expr_len, int var_size, int fvar_size) {
+    int a = p->a, b = p->b, *t = F_jumpTarget(p);
+    if (t && (*t < 0 || *t >= ic->size)) return 0;
+    switch (F_checkedOp(p->op)) {
+        case F_OP_FLIT:
+            return a >= 0 && a < ic->fconst_size;
+        case F_OP_STR: case F_OP_DEFVAR: case F_OP_DEFFVAR:
+        case F_OP_DEFCONST: case F_OP_DEFFCONST: case F_OP_SHOW:
+            return a >= 0 && a < ic->pool_size;
+        case F_OP_WORD:
+            return a >= 0 && a < ic->pool_size && b >= 0 && b <= expr_len;
+        case F_OP_ERR:
+            return a > 0 && a < (int) (sizeof(F_scanError) / sizeof(F_scanError[0]));
+        case F_OP_CONTROL: case F_OP_PCONTROL:
+            return b >= 0 && b <= expr_len;
+        case F_OP_VFETCH: case F_OP_VSTORE: case F_OP_VINC: case F_OP_VDEC: case F_OP_VADDSTORE:
+        case F_OP_VSUBSTORE: case F_OP_DUPVSTORE: case F_OP_VADD: case F_OP_VSUB: case F_OP_VMUL:
+            return a >= 0 && a < var_size;
+        case F_OP_LITVSTORE:
+            return b >= 0 && b < var_size;
+        case F_OP_FVFETCH: case F_OP_FVSTORE:
+            return a >= 0 && a < fvar_size;
+        case F_OP_LGET: case F_OP_LSET: case F_OP_FLGET: case F_OP_FLSET:
+        case F_OP_LADD: case F_OP_LSUB: case F_OP_LMUL: case F_OP_DUPLSET:
+            return a >= 0 && a < ic->locals;
+        case F_OP_LITLSET:
+            return b >= 0 && b < ic->locals;
+        case F_OP_GUARD:
+            return a >= 0 && a < ic->guard_size && b >= 0 && b < ic->size;
+        case F_OP_JIT:
+            return 0;
+    }
+    return p->op >= 0 && p->op < F_OP_COUNT;
+}
+
+static int F_checkGuards(const F_ImageCode *ic, F_Inst *inst, const F_Effect *guard) {
+    const F_Effect *limit = NULL;
+    F_Effect g;
+    int d = 0, f = 0;
+    for (int k = 0; k <= ic->size; k++) {
+        int op = k < ic->size ? inst[k].op : F_OP_END, checked = F_checkedOp(op);
+        int *t = k < ic->size ? F_jumpTarget(&inst[k]) : NULL;
+        int target = t ? *t : op == F_OP_GUARD ? inst[k].b : -1;
+        if (target >= 0 && F_checkedOp(inst[target].op) != inst[target].op) return 0;
+        if (checked != op) {
+            if (!limit) return 0;
+            F_Effect e = F_opEffect(checked);
+            if (e.kind != F_EFFECT_GUARD) return 0;
+            if (e.dneed - d > g.dneed) g.dneed = e.dneed - d;
+            if (e.fneed - f > g.fneed) g.fneed = e.fneed - f;
+            if (d + e.dpeak > g.dpeak) g.dpeak = d + e.dpeak;
+            if (f + e.fpeak > g.fpeak) g.fpeak = f + e.fpeak;
+            d += e.dnet;
+            f += e.fnet;
+            if (!t) continue;
+        }
+        if (limit && (g.dneed > limit->dneed || g.fneed > limit->fneed
+                      || g.dpeak > limit->dpeak || g.fpeak > limit->fpeak))
+            return 0;
+        limit = NULL;
+        if (op == F_OP_GUARD) {
+            limit = &guard[inst[k].a];
+            memset(&g, 0, sizeof(g));
+            d = f = 0;
+        }
+    }
+    return 1;
+}
+
+static int F_checkImage(const F_Source *img) {
+    const F_ImageHeader *h = (const F_ImageHeader *) img->data;
+    if (img->size < sizeof(F_ImageHeader) || memcmp(h->magic, F_IMAGE_MAGIC, 8) ||
+        h->op_count != F_OP_COUNT || h->inst_size != (int) sizeof(F_Inst) || h->size != img->size ||
+        h->var_size > F_MAX_VARS || h->fvar_size > F_MAX_VARS || h->strings > h->size ||
+        !F_imageSpan(h, h->entries, h->dict_size, sizeof(F_ImageEntry)) ||
+        !F_imageSpan(h, h->codes, h->code_count, sizeof(F_ImageCode)) ||
+        !F_imageSpan(h, h->vars, h->var_size, sizeof(int)) ||
+        !F_imageSpan(h, h->fvars, h->fvar_size, sizeof(double)) ||
+        !F_imageSpan(h, h->data, h->data_size, sizeof(int)) ||
+        !F_imageSpan(h, h->fdata, h->fdata_size, sizeof(double)) ||
+        !F_imageSpan(h, h->users, h->user_size, sizeof(int)))
+        return 0;
+    const F_ImageEntry *entry = (const F_ImageEntry *) (img->data + h->entries);
+    const F_ImageCode *icode = (const F_ImageCode *) (img->data + h->codes);
+    for (int i = 0; i < h->dict_size; i++) {
+        const F_ImageEntry *e = &entry[i];
+        if (e->type < F_PRIMITIVE || e->type > F_FCONSTANT || !F_imageString(img->data, h, e->word)
+            || strlen(img->data + h->strings + e->word) >= F_MAX_WORD)
+            return 0;
+        if (e->type == F_VARIABLE && (e->var_index < 0 || e->var_index >= F_MAX_VARS)) return 0;
+        if (e->type != F_FUNCTION) continue;
+        if (!F_imageString(img->data, h, e->expr) || e->code < 0 || e->code >= h->code_count) return 0;
+        const F_ImageCode *ic = &icode[e->code];
+        if (ic->size < 1 || ic->locals < 0 || ic->locals > F_MAX_LOCALS ||
+            !F_imageSpan(h, ic->inst, ic->size, sizeof(F_Inst)) ||
+            !F_imageSpan(h, ic->fconst, ic->fconst_size, sizeof(double)) ||
+            !F_imageSpan(h, ic->pool, ic->pool_size, 1) ||
+            !F_imageSpan(h, ic->guard, ic->guard_size, sizeof(F_Effect)) ||
+            (ic->pool_size && img->data[ic->pool + ic->pool_size - 1] != '\0'))
+            return 0;
+        F_Inst *inst = (F_Inst *) (img->data + ic->inst);
+        int last = F_checkedOp(inst[ic->size - 1].op), expr_len = (int) strlen(img->data + h->strings + e->expr);
+        if (last != F_OP_END && last != F_OP_PEND && last != F_OP_JMP) return 0;
+        for (int k = 0, type; k < ic->size; k++) {
+            int a = inst[k].a;
+            if (!F_checkInst(ic, &inst[k], expr_len, h->var_size, h->fvar_size)) return 0;
+            if (F_instEntry(&inst[k], &type) && (a < 0 || a >= h->dict_size || (type >= 0 && entry[a].type != type)))
+                return 0;
+        }
+        if (!F_checkGuards(ic, inst, (const F_Effect *) (img->data + ic->guard))) return 0;
+    }
+    return 1;
+}
+
+int F_loadImage(F_State *state, const char *filename) {
+    F_Source img;
+    if (F_openSource(&img, filename) < 0) {
+        fprintf(stderr, "[ERROR] Failed to load image `%s`: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    F_ImageHeader *h = (F_ImageHeader *) img.data;
+    if (!F_checkImage(&img)) {
+        fprintf(stderr, "[ERROR] Invalid image `%s`\n", filename);
+        F_closeSource(&img);
+        return -1;
+    }
+    F_ImageEntry *entry = (F_ImageEntry *) (img.data + h->entries);
+    F_ImageCode *icode = (F_ImageCode *) (img.data + h->codes);
+    const char *strings = img.data + h->strings;
+    F_Dict *old = state->dict, *dict = F_createDict();
+    while (dict->capacity < h->dict_size) dict->capacity *= 2;
+    dict->entry = (F_DictEntry *) realloc(dict->entry, dict->capacity * sizeof(F_DictEntry));
+    dict->image_code = (F_Code *) calloc(h->code_count + 1, sizeof(F_Code));
+    for (int i = 0; i < h->dict_size; i++) {
+        F_DictEntry *cur = &dict->entry[i];
+        memset(cur, 0, sizeof(F_DictEntry));
+        cur->word = strings + entry[i].word;
+        cur->type = (F_Type) entry[i].type;
+        cur->effect = entry[i].effect;
+        cur->inlined = entry[i].inlined;
+        dict->size++;
+        F_index(dict, i);
+        if (cur->type == F_PRIMITIVE || cur->type == F_CONTROL) {
+            int idx = F_lookup(old, cur->word);
+            if (idx < 0 || old->entry[idx].type != cur->type) {
+                fprintf(stderr, "[ERROR] Unknown primitive `%s` in image `%s`\n", cur->word, filename);
+                dict->image = img;
+                F_destroyDict(dict);
+                return -1;
+            }
+            if (cur->type == F_PRIMITIVE) cur->func = old->entry[idx].func;
+            else cur->control = old->entry[idx].control;
+        } else if (cur->type == F_FUNCTION) {
+            F_ImageCode *ic = &icode[entry[i].code];
+            F_Code *code = &dict->image_code[entry[i].code];
+            code->inst = (F_Inst *) (img.data + ic->inst);
+            code->size = code->capacity = ic->size;
+            code->fconst = (double *) (img.data + ic->fconst);
+            code->fconst_size = code->fconst_capacity = ic->fconst_size;
+            code->pool = img.data + ic->pool;
+            code->pool_size = code->pool_capacity = ic->pool_size;
+            code->guard = (F_Effect *) (img.data + ic->guard);
+            code->guard_size = ic->guard_size;
+            code->locals = ic->locals;
+            code->effect = ic->effect;
+            code->prefix = ic->prefix;
+            code->version = h->dict_version;
+            code->shared = 2;
+            cur->expr = strings + entry[i].expr;
+            code->src = cur->expr;
+            cur->code = code;
+        } else if (cur->type == F_FCONSTANT) cur->fvalue = entry[i].fvalue;
+        else if (cur->type == F_CONSTANT) cur->value = entry[i].value;
+        else cur->var_index = entry[i].var_index;
+    }
+    dict->users_cap = dict->capacity;
+    dict->users = (F_Users *) calloc(dict->users_cap, sizeof(F_Users));
+    const int *users = (const int *) (img.data + h->users);
+    for (int i = 0, k = 0; i <= h->dict_size && k < h->user_size; i++) {
+        int n = users[k++];
+        if (n < 0 || n > h->user_size - k) break;
+        F_Users *u = i < h->dict_size ? &dict->users[i] : &dict->unresolved;
+        u->capacity = n;
+        u->idx = n ? (int *) malloc(n * sizeof(int)) : NULL;
+        for (int j = 0; j < n; j++, k++)
+            if (i == h->dict_size || (unsigned int) users[k] < (unsigned int) h->dict_size) u->idx[u->size++] = users[k];
+    }
+    dict->version = h->dict_version;
+    dict->var_size = h->var_size;
+    dict->fvar_size = h->fvar_size;
+    memcpy(dict->vars, img.data + h->vars, h->var_size * sizeof(int));
+    memcpy(dict->fvars, img.data + h->fvars, h->fvar_size * sizeof(double));
+    dict->image = img;
+    F_destroyDict(old);
+    state->dict = dict;
+    state->data->size = state->fdata->size = 0;
+    const int *data = (const int *) (img.data + h->data);
+    const double *fdata = (const double *) (img.data + h->fdata);
+    for (int i = 0; i < h->data_size && state->running; i++) F_push(state, data[i]);
+    for (int i = 0; i < h->fdata_size && state->running; i++) F_fpush(state, fdata[i]);
+    return 0;
+}
+
+void F_eval(F_State *state, char *s) {
+    if (!state->running) return;
+    F_Code *code = F_build(state, s);
+    if (!code) return;
+    if (state->data->size < code->prefix.dneed || state->fdata->size < code->prefix.fneed) {
+        fprintf(stderr, "[ERROR] Stack underflow at line %d\n", state->line_count);
+        if (!state->interactive) state->running = 0;
+    } else F_exec(state, code);
+    F_freeCode(code);
+}
+
+void F_define(F_State *state, char *s, int lazy) {
     if (!state->running) return;
-    int i = 1, word_idx = 0, expr_idx = 0;
+    int i = 1, word_idx = 0;
     while (s[i] == ' ') i++;
     while (s[i] != ' ') state->word_buf[word_idx++] = s[i++];
     state->word_buf[word_idx] = '\0';
     while (s[i] == ' ') i++;
-    while (s[i] != ';') state->expr_buf[expr_idx++] = s[i++];
-    state->expr_buf[expr_idx] = '\0';
-    F_addExpr(state, state->word_buf, state->expr_buf);
+    char *end = strchr(s + i, ';');
+    size_t len = end ? (size_t) (end - s - i) : strlen(s + i);
+    char *expr = (char *) malloc(len + 1);
+    memcpy(expr, s + i, len);
+    expr[len] = '\0';
+    if (lazy) F_addLazy(state, state->word_buf, expr);
+    else F_addExpr(state, state->word_buf, expr);
+    free(expr);
+}
+
+void F_compile(F_State *state, char *s) {
+    F_define(state, s, 0);
+}
+
+int F_mread(F_State *state, F_Source *src) {
+    return F_readLine(state, src, &state->line);
 }
 
-int F_mread(F_State *state, FILE *fm) {
-    int c = fgetc(fm);
-    int len = 0, comment = 0, f = 0;
-    while (c != EOF) {
-        f = 0;
-        if (c == '\\') {
-            comment = 1;
-            state->line_count++;
-        } else if (c == '\n' || c == '\r') {
-            f = 1;
-            if (comment) comment = 0;
-            else break;
+void F_setPath(F_State *state, const char *path) {
+    free(state->path);
+    state->path = path ? strdup(path) : NULL;
+}
+
+char *F_resolveModule(F_State *state, const char *filename) {
+    const char *dir = state->path;
+    while (dir && *dir) {
+        size_t len = strcspn(dir, ":");
+        if (len) {
+            char *path = (char *) malloc(len + strlen(filename) + 2);
+            memcpy(path, dir, len);
+            path[len] = '/';
+            strcpy(path + len + 1, filename);
+            FILE *f = fopen(path, "r");
+            if (f) {
+                fclose(f);
+                return path;
+            }
+            free(path);
         }
-        if (!comment && !f)
-            state->module_buf[len++] = c;
-        c = fgetc(fm);
+        dir += len + (dir[len] == ':');
     }
-    state->module_buf[len] = '\0';
-    return c;
+    return strdup(filename);
+}
+
+int F_loadModule(F_State *state, const char *name, const char *filename);
+
+int F_importFile(F_State *state, const char *filename) {
+    return F_loadModule(state, filename, filename);
 }
 
 void F_import(F_State *state, char *s) {
     if (!state->running) return;
-    int saved_line_count = state->line_count;
-    int saved_interactive = state->interactive;
-    state->line_count = 0;
-    state->interactive = 0;
     int i = 1, word_idx = 0;
     char filename[F_MAX_WORD];
     while (s[i] == ' ') i++;
@@ -583,52 +2389,18 @@ void F_import(F_State *state, char *s) {
         filename[word_idx++] = s[i++];
     filename[word_idx] = '\0';
     strcat(filename, ".foo");
-    if (F_find(state, filename)) {
-        state->line_count = saved_line_count;
-        state->interactive = saved_interactive;
-        if (state->interactive)
-            fprintf(stdout, "[INFO] Already load module `%s` before\n", filename);
-        return;
-    }
-    F_addMod(state, filename, 1);
-    FILE *fm = fopen(filename, "r");
-    if (!fm) {
-        fprintf(stderr, "[ERROR] Failed to load module `%s`: %s\n", filename, strerror(errno));
-        if (!saved_interactive) state->running = 0;
-        state->line_count = saved_line_count;
-        state->interactive = saved_interactive;
-        return;
-    }
-    while (state->running && F_mread(state, fm) != EOF) {
-        if (state->module_buf[0] == ':') {
-            F_compile(state, state->module_buf);
-        }
-    }
-    fclose(fm);
-    state->line_count = saved_line_count;
-    state->interactive = saved_interactive;
+    char *path = F_resolveModule(state, filename);
+    F_loadModule(state, filename, path);
+    free(path);
 }
 
 int F_read(F_State *state) {
-    int c = fgetc(state->input);
-    int len = 0, comment = 0, f = 0;
-    while (c != EOF) {
-        f = 0;
-        if (c == '\\') {
-            comment = 1;
-            state->line_count++;
-        } else if (c == '\n' || c == '\r') {
-            f = 1;
-            if (comment) comment = 0;
-            else break;
-        }
-        if (!comment && !f)
-            state->line_buf[len++] = c;
-        c = fgetc(state->input);
-    }
-    state->line_buf[len] = '\0';
-    //puts(state->line_buf);
-    return c;
+    if (state->interactive) {
+        F_flush(state);
+        fflush(stdout);
+    }
+    if (!state->source.data) F_streamSource(&state->source, state->input);
+    return F_readLine(state, &state->source, &state->line);
 }
 
 void F_add(F_State *state) {
@@ -770,8 +2542,8 @@ void F_pop_stack(F_State *state) {
         //else state->data->size = 0;
         return;
     }
-    int val = F_popValue(state->data);
-    printf("%d\n", val);
+    F_putInt(state, F_popValue(state->data));
+    F_putc(state, '\n');
 }
 
 void F_pop_silent(F_State *state) {
@@ -785,10 +2557,14 @@ void F_pop_silent(F_State *state) {
 }
 
 void F_print_stack(F_State *state) {
-    printf("<%d> ", state->data->size);
-    for (int i = 0; i < state->data->size; i++)
-        printf("%d ", state->data->stack[i]);
-    putchar('\n');
+    F_putc(state, '<');
+    F_putInt(state, state->data->size);
+    F_puts(state, "> ");
+    for (int i = 0; i < state->data->size; i++) {
+        F_putInt(state, state->data->stack[i]);
+        F_putc(state, ' ');
+    }
+    F_putc(state, '\n');
 }
 
 void F_dup(F_State *state) {
@@ -860,8 +2636,8 @@ void F_fpop_stack(F_State *state) {
         //else state->fdata->size = 0;
         return;
     }
-    double val = F_fpopValue(state->fdata);
-    printf("%f\n", val);
+    F_putFloat(state, F_fpopValue(state->fdata));
+    F_putc(state, '\n');
 }
 
 void F_fpop_silent(F_State *state) {
@@ -875,10 +2651,14 @@ void F_fpop_silent(F_State *state) {
 }
 
 void F_fprint_stack(F_State *state) {
-    printf("<%d> ", state->fdata->size);
-    for (int i = 0; i < state->fdata->size; i++)
-        printf("%f ", state->fdata->stack[i]);
-    putchar('\n');
+    F_putc(state, '<');
+    F_putInt(state, state->fdata->size);
+    F_puts(state, "> ");
+    for (int i = 0; i < state->fdata->size; i++) {
+        F_putFloat(state, state->fdata->stack[i]);
+        F_putc(state, ' ');
+    }
+    F_putc(state, '\n');
 }
 
 void F_fdup(F_State *state) {
@@ -941,12 +2721,12 @@ void F_else(F_State *state, const char *s, int *pos) {
 }
 
 void F_begin(F_State *state, const char *s, int *pos) {
-    if (state->loop->size >= state->loop->capacity) {
-        fprintf(stderr, "[ERROR] Loop stack overflow at line %d\n", state->line_count);
-        state->running = 0;
-        return;
+    F_Stack *loop = state->loop;
+    if (loop->size >= loop->capacity) {
+        loop->capacity *= 2;
+        loop->stack = (int *) realloc(loop->stack, loop->capacity * sizeof(int));
     }
-    state->loop->stack[state->loop->size++] = *pos;
+    F_pushValue(loop, *pos);
 }
 
 void F_until(F_State *state, const char *s, int *pos) {
@@ -960,18 +2740,22 @@ void F_until(F_State *state, const char *s, int *pos) {
     else state->loop->size--;
 }
 
-void F_var(F_State *state, const char *s, int *pos) {
+void F_defVar(F_State *state, const char *word) {
     if (state->dict->var_size >= F_MAX_VARS) {
         fprintf(stderr, "[ERROR] Variable limit reached at line %d\n", state->line_count);
         state->running = 0;
         return;
     }
+    F_addVar(state, word, state->data->size > 0 ? F_pop(state) : 0);
+}
+
+void F_var(F_State *state, const char *s, int *pos) {
     int i = *pos, word_idx = 0;
     while (s[i] == ' ') i++;
     while (s[i] != ' ' && s[i] != '\0') state->word_buf[word_idx++] = s[i++];
     state->word_buf[word_idx] = '\0';
     *pos = i;
-    F_addVar(state, state->word_buf, state->data->size > 0 ? F_pop(state) : 0);
+    F_defVar(state, state->word_buf);
 }
 
 void F_fetch(F_State *state) {
@@ -987,7 +2771,8 @@ void F_store(F_State *state) {
 
 void F_query(F_State *state) {
     int var_idx = F_pop(state);
-    printf("%d\n", state->dict->vars[var_idx]);
+    F_putInt(state, state->dict->vars[var_idx]);
+    F_putc(state, '\n');
 }
 
 void F_increase(F_State *state) {
@@ -1024,18 +2809,56 @@ void F_div_store(F_State *state) {
     state->dict->vars[var_idx] /= x;
 }
 
-void F_fvar(F_State *state, const char *s, int *pos) {
+void F_defFVar(F_State *state, const char *word) {
     if (state->dict->fvar_size >= F_MAX_VARS) {
         fprintf(stderr, "[ERROR] Variable limit reached at line %d\n", state->line_count);
         state->running = 0;
         return;
     }
+    F_faddVar(state, word, state->fdata->size > 0 ? F_fpop(state) : 0.0);
+}
+
+void F_fvar(F_State *state, const char *s, int *pos) {
+    int i = *pos, word_idx = 0;
+    while (s[i] == ' ') i++;
+    while (s[i] != ' ' && s[i] != '\0') state->word_buf[word_idx++] = s[i++];
+    state->word_buf[word_idx] = '\0';
+    *pos = i;
+    F_defFVar(state, state->word_buf);
+}
+
+void F_defConst(F_State *state, const char *word) {
+    if (state->data->size <= 0) {
+        F_pop(state);
+        return;
+    }
+    F_addConst(state, word, F_pop(state));
+}
+
+void F_const(F_State *state, const char *s, int *pos) {
+    int i = *pos, word_idx = 0;
+    while (s[i] == ' ') i++;
+    while (s[i] != ' ' && s[i] != '\0') state->word_buf[word_idx++] = s[i++];
+    state->word_buf[word_idx] = '\0';
+    *pos = i;
+    F_defConst(state, state->word_buf);
+}
+
+void F_defFConst(F_State *state, const char *word) {
+    if (state->fdata->size <= 0) {
+        F_fpop(state);
+        return;
+    }
+    F_faddConst(state, word, F_fpop(state));
+}
+
+void F_fconst(F_State *state, const char *s, int *pos) {
     int i = *pos, word_idx = 0;
     while (s[i] == ' ') i++;
     while (s[i] != ' ' && s[i] != '\0') state->word_buf[word_idx++] = s[i++];
     state->word_buf[word_idx] = '\0';
     *pos = i;
-    F_faddVar(state, state->word_buf, state->fdata->size > 0 ? F_fpop(state) : 0.0);
+    F_defFConst(state, state->word_buf);
 }
 
 void F_ffetch(F_State *state) {
@@ -1051,7 +2874,8 @@ void F_fstore(F_State *state) {
 
 void F_fquery(F_State *state) {
     int var_idx = F_pop(state);
-    printf("%f\n", state->dict->fvars[var_idx]);
+    F_putFloat(state, state->dict->fvars[var_idx]);
+    F_putc(state, '\n');
 }
 
 void F_fadd_store(F_State *state) {
@@ -1089,8 +2913,8 @@ void F_itof(F_State *state) {
 }
 
 void F_emit(F_State *state) {
-    putchar(F_pop(state));
-    if (state->interactive) putchar('\n');
+    F_putc(state, F_pop(state));
+    if (state->interactive) F_putc(state, '\n');
 }
 
 void F_cr(F_State *state) {
@@ -1107,22 +2931,26 @@ void F_tab(F_State *state) {
 
 void F_geti(F_State *state) {
     int value;
+    F_flush(state);
     scanf("%d", &value);
     F_push(state, value);
 }
 
 void F_getf(F_State *state) {
     double value;
+    F_flush(state);
     scanf("%lf", &value);
     F_fpush(state, value);
 }
 
 void F_getc(F_State *state) {
+    F_flush(state);
     int c = getchar();
     F_push(state, c);
 }
 
 void F_bye(F_State *state) {
+    F_flush(state);
     state->running = 0;
 }
 
@@ -1178,67 +3006,2790 @@ void F_pow(F_State *state) {
     F_fpush(state, pow(x, y));
 }
 
-void F_initState(F_State *state) {
-    F_addFunc(state, "+", F_add);
-    F_addFunc(state, "-", F_sub);
-    F_addFunc(state, "*", F_mul);
-    F_addFunc(state, "/", F_div);
-    F_addFunc(state, "%", F_mod);
+F_Code *F_createCode(const char *src) {
+    F_Code *code = (F_Code *) malloc(sizeof(F_Code));
+    code->capacity = 16;
+    code->inst = (F_Inst *) malloc(code->capacity * sizeof(F_Inst));
+    code->size = 0;
+    code->fconst = NULL;
+    code->fconst_size = 0;
+    code->fconst_capacity = 0;
+    code->pool = NULL;
+    code->pool_size = 0;
+    code->pool_capacity = 0;
+    code->src = src;
+    code->version = 0;
+    memset(&code->effect, 0, sizeof(F_Effect));
+    memset(&code->prefix, 0, sizeof(F_Effect));
+    code->guard = NULL;
+    code->guard_size = 0;
+    code->locals = 0;
+    code->shared = 0;
+    code->calls = 0;
+    code->jit = NULL;
+    code->refs = NULL;
+    code->ref_size = 0;
+    code->next = NULL;
+    return code;
+}
 
-    F_addFunc(state, ">", F_greater);
-    F_addFunc(state, "<", F_less);
-    F_addFunc(state, ">=", F_greater_equal);
-    F_addFunc(state, "<=", F_less_equal);
-    F_addFunc(state, "==", F_equal);
-    F_addFunc(state, "~=", F_not_equal);
+void F_freeJit(F_Jit *jit);
+
+void F_freeCode(F_Code *code) {
+    if (!code || code->shared) return;
+    F_freeJit(code->jit);
+    free(code->inst);
+    free(code->fconst);
+    free(code->pool);
+    free(code->guard);
+    free(code->refs);
+    free(code);
+}
 
-    F_addFunc(state, ".", F_pop_stack);
-    F_addFunc(state, ".x", F_pop_silent);
-    F_addFunc(state, ".s", F_print_stack);
-    F_addFunc(state, "dup", F_dup);
-    F_addFunc(state, "swp", F_swap);
-    F_addFunc(state, "pick", F_pick);
-    F_addFunc(state, "!pick", F_pick_set);
-    F_addFunc(state, "depth", F_depth);
+int F_emitOp(F_Code *code, int op, int a, int b) {
+    if (code->size >= code->capacity) {
+        code->capacity *= 2;
+        code->inst = (F_Inst *) realloc(code->inst, code->capacity * sizeof(F_Inst));
+    }
+    code->inst[code->size].op = op;
+    code->inst[code->size].a = a;
+    code->inst[code->size].b = b;
+    return code->size++;
+}
 
-    F_addControl(state, "if", F_if);
-    F_addControl(state, "else", F_else);
-    F_addControl(state, "then", NULL);
-    F_addControl(state, "begin", F_begin);
-    F_addControl(state, "until", F_until);
+int F_addFloat(F_Code *code, double x) {
+    if (code->fconst_size >= code->fconst_capacity) {
+        code->fconst_capacity = code->fconst_capacity ? code->fconst_capacity * 2 : 4;
+        code->fconst = (double *) realloc(code->fconst, code->fconst_capacity * sizeof(double));
+    }
+    code->fconst[code->fconst_size] = x;
+    return code->fconst_size++;
+}
 
-    F_addControl(state, "var", F_var);
-    F_addFunc(state, "@", F_fetch);
-    F_addFunc(state, "!", F_store);
-    F_addFunc(state, "?", F_query);
-    F_addFunc(state, "++", F_increase);
-    F_addFunc(state, "--", F_decrease);
-    F_addFunc(state, "+!", F_add_store);
-    F_addFunc(state, "-!", F_sub_store);
-    F_addFunc(state, "*!", F_mul_store);
-    F_addFunc(state, "/!", F_div_store);
+int F_intern(F_Code *code, const char *s, int len) {
+    if (code->pool_size + len + 1 > code->pool_capacity) {
+        while (code->pool_size + len + 1 > code->pool_capacity)
+            code->pool_capacity = code->pool_capacity ? code->pool_capacity * 2 : 64;
+        code->pool = (char *) realloc(code->pool, code->pool_capacity);
+    }
+    int offset = code->pool_size;
+    memcpy(code->pool + offset, s, len);
+    code->pool[offset + len] = '\0';
+    code->pool_size += len + 1;
+    return offset;
+}
 
-    F_addFunc(state, "emit", F_emit);
-    F_addFunc(state, "<cr>", F_cr);
-    F_addFunc(state, "<space>", F_space);
-    F_addFunc(state, "<tab>", F_tab);
-    F_addFunc(state, "geti", F_geti);
-    F_addFunc(state, "getf", F_getf);
-    F_addFunc(state, "getc", F_getc);
-    F_addControl(state, "show", F_show);
-    F_addFunc(state, "bye", F_bye);
-    
-    F_addFunc(state, "f+", F_fadd);
-    F_addFunc(state, "f-", F_fsub);
-    F_addFunc(state, "f*", F_fmul);
-    F_addFunc(state, "f/", F_fdiv);
-    F_addFunc(state, "f%", F_fmod);
+int F_primOp(void (*func)(F_State *)) {
+#define F_OP_MATCH(op, fn) if (func == fn) return F_OP_##op;
+    F_BUILTINS(F_OP_MATCH)
+#undef F_OP_MATCH
+    return F_OP_PRIM;
+}
 
-    F_addFunc(state, "f>", F_fgreater);
-    F_addFunc(state, "f<", F_fless);
-    F_addFunc(state, "f>=", F_fgreater_equal);
-    F_addFunc(state, "f<=", F_fless_equal);
-    F_addFunc(state, "f==", F_fequal);
+void (*F_primFunc(int op))(F_State *) {
+    switch (op) {
+#define F_OP_FUNC(op, fn) case F_OP_##op: return fn;
+        F_BUILTINS(F_OP_FUNC)
+#undef F_OP_FUNC
+    }
+    return NULL;
+}
+
+static F_Effect F_effect(int kind, int dn, int dp, int dd, int fn, int fp, int fd) {
+    F_Effect e = {kind, dn, dp, dd, fn, fp, fd};
+    return e;
+}
+
+#define F_DEFF(kind, dn, dp, dd, fn, fp, fd) F_effect(F_EFFECT_##kind, dn, dp, dd, fn, fp, fd)
+#define F_INT(dn, dp, dd) F_DEFF(GUARD, dn, dp, dd, 0, 0, 0)
+#define F_FLT(fn, fp, fd) F_DEFF(GUARD, 0, 0, 0, fn, fp, fd)
+
+F_Effect F_opEffect(int op) {
+    switch (op) {
+        case F_OP_LIT: case F_OP_VAR: case F_OP_DEPTH: case F_OP_FDEPTH: case F_OP_VFETCH:
+        case F_OP_LGET:
+            return F_INT(0, 1, 1);
+        case F_OP_FLIT: case F_OP_FLGET:
+            return F_FLT(0, 1, 1);
+        case F_OP_JZ: case F_OP_UNTIL: case F_OP_DROP: case F_OP_INC: case F_OP_DEC: case F_OP_LSET:
+            return F_INT(1, 0, -1);
+        case F_OP_JMP: case F_OP_LITLSET:
+            return F_INT(0, 0, 0);
+        case F_OP_DEFCONST: case F_OP_DOT: case F_OP_QUERY: case F_OP_EMIT: case F_OP_FQUERY:
+            return F_DEFF(KNOWN, 1, 0, -1, 0, 0, 0);
+        case F_OP_DEFFCONST: case F_OP_FDOT:
+            return F_DEFF(KNOWN, 0, 0, 0, 1, 0, -1);
+        case F_OP_SHOW: case F_OP_DOTS: case F_OP_FDOTS:
+            return F_DEFF(KNOWN, 0, 0, 0, 0, 0, 0);
+        case F_OP_ADD: case F_OP_SUB: case F_OP_MUL: case F_OP_GT: case F_OP_LT: case F_OP_GE:
+        case F_OP_LE: case F_OP_EQ: case F_OP_NE: case F_OP_NIP:
+            return F_INT(2, 0, -1);
+        case F_OP_DIV: case F_OP_MOD:
+            return F_DEFF(KNOWN, 2, 0, -1, 0, 0, 0);
+        case F_OP_DUP:
+            return F_INT(1, 1, 1);
+        case F_OP_SWAP:
+            return F_INT(2, 0, 0);
+        case F_OP_FETCH: case F_OP_DUPLSET:
+            return F_INT(1, 0, 0);
+        case F_OP_STORE: case F_OP_ADDSTORE: case F_OP_SUBSTORE: case F_OP_MULSTORE:
+        case F_OP_DIVSTORE:
+            return F_INT(2, 0, -2);
+        case F_OP_FADD: case F_OP_FSUB: case F_OP_FMUL:
+            return F_FLT(2, 0, -1);
+        case F_OP_FDIV: case F_OP_FMOD: case F_OP_POW:
+            return F_DEFF(KNOWN, 0, 0, 0, 2, 0, -1);
+        case F_OP_FGT: case F_OP_FLT: case F_OP_FGE: case F_OP_FLE: case F_OP_FEQ: case F_OP_FNE:
+            return F_DEFF(GUARD, 0, 1, 1, 2, 0, -2);
+        case F_OP_FDROP: case F_OP_FLSET:
+            return F_FLT(1, 0, -1);
+        case F_OP_FDUP:
+            return F_FLT(1, 1, 1);
+        case F_OP_FSWAP:
+            return F_FLT(2, 0, 0);
+        case F_OP_FFETCH: case F_OP_ITOF:
+            return F_DEFF(GUARD, 1, 0, -1, 0, 1, 1);
+        case F_OP_FSTORE: case F_OP_FADDSTORE: case F_OP_FSUBSTORE: case F_OP_FMULSTORE:
+        case F_OP_FDIVSTORE:
+            return F_DEFF(GUARD, 1, 0, -1, 1, 0, -1);
+        case F_OP_FTOI:
+            return F_DEFF(GUARD, 0, 1, 1, 1, 0, -1);
+        case F_OP_VSTORE: case F_OP_VADDSTORE: case F_OP_VSUBSTORE: case F_OP_JNGT: case F_OP_JNLT:
+        case F_OP_JNGE: case F_OP_JNLE: case F_OP_JNEQ: case F_OP_JNNE:
+            return F_INT(1, 1, -1);
+        case F_OP_VINC: case F_OP_VDEC:
+            return F_INT(0, 1, 0);
+        case F_OP_FVFETCH:
+            return F_DEFF(GUARD, 0, 1, 0, 0, 1, 1);
+        case F_OP_FVSTORE:
+            return F_DEFF(GUARD, 0, 1, 0, 1, 0, -1);
+        case F_OP_LITVSTORE:
+            return F_INT(0, 2, 0);
+        case F_OP_DUPVSTORE:
+            return F_INT(1, 2, 0);
+        case F_OP_ADDLIT: case F_OP_SUBLIT: case F_OP_MULLIT: case F_OP_GTLIT: case F_OP_LTLIT:
+        case F_OP_GELIT: case F_OP_LELIT: case F_OP_EQLIT: case F_OP_NELIT: case F_OP_VADD:
+        case F_OP_VSUB: case F_OP_VMUL: case F_OP_SQUARE: case F_OP_LADD: case F_OP_LSUB:
+        case F_OP_LMUL:
+            return F_INT(1, 1, 0);
+        case F_OP_CR: case F_OP_SPACE: case F_OP_TAB: case F_OP_GETI: case F_OP_GETC:
+            return F_DEFF(KNOWN, 0, 1, 1, 0, 0, 0);
+        case F_OP_GETF:
+            return F_DEFF(KNOWN, 0, 0, 0, 0, 1, 1);
+        case F_OP_SQRT: case F_OP_SIN: case F_OP_COS: case F_OP_TAN: case F_OP_CEIL:
+        case F_OP_FLOOR: case F_OP_FABS: case F_OP_LOG: case F_OP_LOG10:
+            return F_DEFF(KNOWN, 0, 0, 0, 1, 0, 0);
+    }
+    return F_DEFF(UNKNOWN, 0, 0, 0, 0, 0, 0);
+}
+
+#undef F_DEFF
+#undef F_INT
+#undef F_FLT
+
+int F_uncheckedOp(int op) {
+    switch (op) {
+#define F_U_CASE(op) case F_OP_##op: return F_OP_U_##op;
+        F_GUARDED(F_U_CASE)
+#undef F_U_CASE
+    }
+    return op;
+}
+
+int *F_jumpTarget(F_Inst *p) {
+    switch (p->op) {
+        case F_OP_JZ: case F_OP_JMP: case F_OP_UNTIL:
+        case F_OP_U_JZ: case F_OP_U_UNTIL:
+            return &p->a;
+        case F_OP_JNGT: case F_OP_JNLT: case F_OP_JNGE:
+        case F_OP_JNLE: case F_OP_JNEQ: case F_OP_JNNE:
+        case F_OP_U_JNGT: case F_OP_U_JNLT: case F_OP_U_JNGE:
+        case F_OP_U_JNLE: case F_OP_U_JNEQ: case F_OP_U_JNNE:
+            return &p->b;
+    }
+    return NULL;
+}
+
+enum {
+    F_CTL_IF,
+    F_CTL_ELSE,
+    F_CTL_BEGIN
+};
+
+typedef struct F_Compiler {
+    F_State *state;
+    F_Code *code;
+    const char *src;
+    int *late;
+    int late_size;
+    int *local;
+    int local_size;
+    int *ctl;
+    int ctl_size;
+    int ctl_capacity;
+    int mark;
+    int tail;
+    int custom;
+    int inline_stack[F_INLINE_DEPTH];
+    int inline_depth;
+    int inline_size;
+    int prefix_d;
+    int prefix_f;
+    int prefix_end;
+    const char *error;
+    const char *error_word;
+} F_Compiler;
+
+int F_isLate(F_Compiler *c, const char *word) {
+    for (int i = 0; i < c->late_size; i++)
+        if (!strcmp(c->code->pool + c->late[i], word)) return 1;
+    return 0;
+}
+
+int F_findLocal(F_Compiler *c, const char *word, int len) {
+    for (int i = c->local_size - 1; i >= 0; i--) {
+        const char *name = c->code->pool + c->local[i * 2];
+        if (!strncmp(name, word, len) && name[len] == '\0') return i;
+    }
+    return -1;
+}
+
+int F_fuse(F_Inst *x, const F_Inst *y) {
+    switch (x->op) {
+        case F_OP_VAR:
+            switch (y->op) {
+                case F_OP_FETCH: x->op = F_OP_VFETCH; return 1;
+                case F_OP_STORE: x->op = F_OP_VSTORE; return 1;
+                case F_OP_INC: x->op = F_OP_VINC; return 1;
+                case F_OP_DEC: x->op = F_OP_VDEC; return 1;
+                case F_OP_ADDSTORE: x->op = F_OP_VADDSTORE; return 1;
+                case F_OP_SUBSTORE: x->op = F_OP_VSUBSTORE; return 1;
+                case F_OP_FFETCH: x->op = F_OP_FVFETCH; return 1;
+                case F_OP_FSTORE: x->op = F_OP_FVSTORE; return 1;
+            }
+            return 0;
+        case F_OP_LIT:
+            switch (y->op) {
+                case F_OP_VSTORE: x->op = F_OP_LITVSTORE; x->b = y->a; return 1;
+                case F_OP_LSET: x->op = F_OP_LITLSET; x->b = y->a; return 1;
+                case F_OP_ADD: x->op = F_OP_ADDLIT; return 1;
+                case F_OP_SUB: x->op = F_OP_SUBLIT; return 1;
+                case F_OP_MUL: x->op = F_OP_MULLIT; return 1;
+                case F_OP_GT: x->op = F_OP_GTLIT; return 1;
+                case F_OP_LT: x->op = F_OP_LTLIT; return 1;
+                case F_OP_GE: x->op = F_OP_GELIT; return 1;
+                case F_OP_LE: x->op = F_OP_LELIT; return 1;
+                case F_OP_EQ: x->op = F_OP_EQLIT; return 1;
+                case F_OP_NE: x->op = F_OP_NELIT; return 1;
+            }
+            return 0;
+        case F_OP_GTLIT: case F_OP_LTLIT: case F_OP_GELIT:
+        case F_OP_LELIT: case F_OP_EQLIT: case F_OP_NELIT:
+            if (y->op != F_OP_JZ && y->op != F_OP_UNTIL) return 0;
+            x->op += F_OP_JNGT - F_OP_GTLIT;
+            x->b = y->a;
+            return 1;
+        case F_OP_VFETCH:
+            switch (y->op) {
+                case F_OP_ADD: x->op = F_OP_VADD; return 1;
+                case F_OP_SUB: x->op = F_OP_VSUB; return 1;
+                case F_OP_MUL: x->op = F_OP_VMUL; return 1;
+            }
+            return 0;
+        case F_OP_LGET:
+            switch (y->op) {
+                case F_OP_ADD: x->op = F_OP_LADD; return 1;
+                case F_OP_SUB: x->op = F_OP_LSUB; return 1;
+                case F_OP_MUL: x->op = F_OP_LMUL; return 1;
+            }
+            return 0;
+        case F_OP_DUP:
+            if (y->op == F_OP_MUL) x->op = F_OP_SQUARE;
+            else if (y->op == F_OP_VSTORE || y->op == F_OP_LSET) {
+                x->op = y->op == F_OP_VSTORE ? F_OP_DUPVSTORE : F_OP_DUPLSET;
+                x->a = y->a;
+            } else return 0;
+            return 1;
+        case F_OP_SWAP:
+            if (y->op != F_OP_DROP) return 0;
+            x->op = F_OP_NIP;
+            return 1;
+    }
+    return 0;
+}
+
+int F_fold(F_Compiler *c) {
+    F_Code *code = c->code;
+    F_Inst *p = &code->inst[code->size - 1];
+    int n = code->size - c->mark;
+    if (n >= 3 && p[-2].op == F_OP_LIT && p[-1].op == F_OP_LIT) {
+        int a = p[-2].a, b = p[-1].a;
+        unsigned ua = a, ub = b;
+        switch (p->op) {
+            case F_OP_ADD: a = (int)(ua + ub); break;
+            case F_OP_SUB: a = (int)(ua - ub); break;
+            case F_OP_MUL: a = (int)(ua * ub); break;
+            case F_OP_DIV:
+                if (b == 0 || (a == INT_MIN && b == -1)) return 0;
+                a /= b;
+                break;
+            case F_OP_MOD:
+                if (b == 0 || (a == INT_MIN && b == -1)) return 0;
+                a %= b;
+                break;
+            case F_OP_GT: a = a > b; break;
+            case F_OP_LT: a = a < b; break;
+            case F_OP_GE: a = a >= b; break;
+            case F_OP_LE: a = a <= b; break;
+            case F_OP_EQ: a = a == b; break;
+            case F_OP_NE: a = a != b; break;
+            default: return 0;
+        }
+        p[-2].a = a;
+        code->size -= 2;
+        return 1;
+    }
+    if (n >= 3 && p[-2].op == F_OP_FLIT && p[-1].op == F_OP_FLIT) {
+        double a = code->fconst[p[-2].a], b = code->fconst[p[-1].a];
+        int cmp = 1;
+        switch (p->op) {
+            case F_OP_FADD: a += b; cmp = 0; break;
+            case F_OP_FSUB: a -= b; cmp = 0; break;
+            case F_OP_FMUL: a *= b; cmp = 0; break;
+            case F_OP_FDIV:
+                if (b == 0) return 0;
+                a /= b; cmp = 0;
+                break;
+            case F_OP_FMOD:
+                if (b == 0) return 0;
+                a = fmod(a, b); cmp = 0;
+                break;
+            case F_OP_POW: a = pow(a, b); cmp = 0; break;
+            case F_OP_FGT: p[-2].a = a > b; break;
+            case F_OP_FLT: p[-2].a = a < b; break;
+            case F_OP_FGE: p[-2].a = a >= b; break;
+            case F_OP_FLE: p[-2].a = a <= b; break;
+            case F_OP_FEQ: p[-2].a = a == b; break;
+            case F_OP_FNE: p[-2].a = a != b; break;
+            default: return 0;
+        }
+        if (cmp) p[-2].op = F_OP_LIT;
+        else code->fconst[p[-2].a] = a;
+        code->size -= 2;
+        return 1;
+    }
+    if (n >= 2 && p[-1].op == F_OP_FLIT) {
+        double *x = &code->fconst[p[-1].a];
+        switch (p->op) {
+            case F_OP_SQRT: *x = sqrt(*x); break;
+            case F_OP_SIN: *x = sin(*x); break;
+            case F_OP_COS: *x = cos(*x); break;
+            case F_OP_TAN: *x = tan(*x); break;
+            case F_OP_CEIL: *x = ceil(*x); break;
+            case F_OP_FLOOR: *x = floor(*x); break;
+            case F_OP_FABS: *x = fabs(*x); break;
+            case F_OP_LOG: *x = log(*x); break;
+            case F_OP_LOG10: *x = log10(*x); break;
+            case F_OP_FTOI:
+                if (!(*x > INT_MIN - 1.0 && *x < INT_MAX + 1.0)) return 0;
+                p[-1].op = F_OP_LIT;
+                p[-1].a = (int)*x;
+                break;
+            default: return 0;
+        }
+        code->size--;
+        return 1;
+    }
+    if (n >= 2 && p[-1].op == F_OP_LIT && p->op == F_OP_ITOF) {
+        p[-1].op = F_OP_FLIT;
+        p[-1].a = F_addFloat(code, (double)p[-1].a);
+        code->size--;
+        return 1;
+    }
+    return 0;
+}
+
+int F_pureOp(int op) {
+    switch (op) {
+        case F_OP_JZ: case F_OP_JMP: case F_OP_UNTIL:
+        case F_OP_STORE: case F_OP_INC: case F_OP_DEC:
+        case F_OP_ADDSTORE: case F_OP_SUBSTORE: case F_OP_MULSTORE: case F_OP_DIVSTORE:
+        case F_OP_FSTORE: case F_OP_FADDSTORE: case F_OP_FSUBSTORE: case F_OP_FMULSTORE: case F_OP_FDIVSTORE:
+        case F_OP_VSTORE: case F_OP_VINC: case F_OP_VDEC: case F_OP_VADDSTORE: case F_OP_VSUBSTORE:
+        case F_OP_FVSTORE: case F_OP_LITVSTORE: case F_OP_DUPVSTORE:
+        case F_OP_LSET: case F_OP_FLSET: case F_OP_DUPLSET: case F_OP_LITLSET:
+            return 0;
+        case F_OP_STR:
+            return 1;
+    }
+    return F_opEffect(op).kind == F_EFFECT_GUARD;
+}
+
+void F_trackPrefix(F_Compiler *c, int op, int a) {
+    F_Effect *prefix = &c->code->prefix, e;
+    if (c->prefix_end || c->inline_depth || !F_pureOp(op)) {
+        c->prefix_end = 1;
+        return;
+    }
+    e = F_opEffect(op);
+    if (op == F_OP_STR) e.dnet = (int) strlen(c->code->pool + a) + 1;
+    if (e.dneed - c->prefix_d > prefix->dneed) prefix->dneed = e.dneed - c->prefix_d;
+    if (e.fneed - c->prefix_f > prefix->fneed) prefix->fneed = e.fneed - c->prefix_f;
+    c->prefix_d += e.dnet;
+    c->prefix_f += e.fnet;
+}
+
+int F_compileOp(F_Compiler *c, int op, int a, int b) {
+    F_Code *code = c->code;
+    F_trackPrefix(c, op, a);
+    F_emitOp(code, op, a, b);
+    while (c->state->peephole) {
+        if (F_fold(c)) c->state->folded++;
+        else if (code->size - 2 >= c->mark
+                 && F_fuse(&code->inst[code->size - 2], &code->inst[code->size - 1])) {
+            code->size--;
+            c->state->fused[code->inst[code->size - 1].op]++;
+        } else break;
+    }
+    return code->size - 1;
+}
+
+void F_patch(F_Compiler *c, int at) {
+    F_Inst *p = &c->code->inst[at];
+    if (p->op == F_OP_JZ || p->op == F_OP_JMP) p->a = c->code->size;
+    else p->b = c->code->size;
+    c->mark = c->code->size;
+}
+
+void F_pushCtl(F_Compiler *c, int kind, int at) {
+    if (c->ctl_size + 2 > c->ctl_capacity) {
+        c->ctl_capacity = c->ctl_capacity ? c->ctl_capacity * 2 : 16;
+        c->ctl = (int *) realloc(c->ctl, c->ctl_capacity * sizeof(int));
+    }
+    c->ctl[c->ctl_size++] = kind;
+    c->ctl[c->ctl_size++] = at;
+}
+
+int F_topCtl(F_Compiler *c) {
+    return c->ctl_size ? c->ctl[c->ctl_size - 2] : -1;
+}
+
+int F_popCtl(F_Compiler *c) {
+    c->ctl_size -= 2;
+    return c->ctl[c->ctl_size + 1];
+}
+
+void F_compileError(F_Compiler *c, const char *msg, const char *word) {
+    if (c->error) return;
+    c->error = msg;
+    c->error_word = word;
+}
+
+void F_compileLocals(F_Compiler *c, const char *s, int *pos) {
+    int i = *pos, first = c->local_size, bound = first, mode = 0, fl = 0;
+    for (;;) {
+        while (s[i] == ' ') i++;
+        if (s[i] == '\0') {
+            F_compileError(c, "Unterminated", "{");
+            break;
+        }
+        int start = i;
+        while (s[i] != ' ' && s[i] != '\0') i++;
+        int len = i - start;
+        if (len == 1 && s[start] == '}') break;
+        if (mode == 2) continue;
+        if (len == 2 && !strncmp(s + start, "--", 2)) mode = 2;
+        else if (len == 1 && s[start] == '|') mode = 1;
+        else if (len == 2 && !strncmp(s + start, "f:", 2)) fl = 1;
+        else {
+            c->local = (int *) realloc(c->local, (c->local_size + 1) * 2 * sizeof(int));
+            c->local[c->local_size * 2] = F_intern(c->code, s + start, len);
+            c->local[c->local_size * 2 + 1] = fl;
+            c->local_size++;
+            if (!mode) bound = c->local_size;
+            fl = 0;
+        }
+    }
+    for (int k = bound - 1; k >= first; k--)
+        F_compileOp(c, c->local[k * 2 + 1] ? F_OP_FLSET : F_OP_LSET, k, 0);
+    *pos = i;
+}
+
+void F_compileIf(F_Compiler *c) {
+    F_pushCtl(c, F_CTL_IF, F_compileOp(c, F_OP_JZ, 0, 0));
+}
+
+void F_compileElse(F_Compiler *c) {
+    int at = F_compileOp(c, F_OP_JMP, 0, 0);
+    if (F_topCtl(c) == F_CTL_IF) F_patch(c, F_popCtl(c));
+    else F_compileError(c, "Unmatched", "else");
+    F_pushCtl(c, F_CTL_ELSE, at);
+}
+
+void F_compileBegin(F_Compiler *c) {
+    c->mark = c->code->size;
+    F_pushCtl(c, F_CTL_BEGIN, c->code->size);
+}
+
+void F_compileUntil(F_Compiler *c) {
+    if (F_topCtl(c) == F_CTL_BEGIN) {
+        F_compileOp(c, F_OP_UNTIL, F_popCtl(c), 0);
+        return;
+    }
+    F_compileError(c, "Unmatched", "until");
+    for (int i = c->ctl_size - 2; i >= 0; i -= 2) {
+        if (c->ctl[i] == F_CTL_BEGIN) {
+            F_compileOp(c, F_OP_UNTIL, c->ctl[i + 1], 0);
+            memmove(c->ctl + i, c->ctl + i + 2, (c->ctl_size - i - 2) * sizeof(int));
+            c->ctl_size -= 2;
+            return;
+        }
+    }
+    F_compileOp(c, F_OP_ERR, 3, 0);
+}
+
+void F_compileThen(F_Compiler *c) {
+    int kind = F_topCtl(c);
+    if (kind == F_CTL_IF || kind == F_CTL_ELSE) F_patch(c, F_popCtl(c));
+    else F_compileError(c, "Unmatched", "then");
+}
+
+int F_controlKind(void (*control)(F_State *, const char *, int *)) {
+    void (*known[])(F_State *, const char *, int *) = {
+        F_if, F_else, F_begin, F_until, F_var, F_fvar, F_show, F_const, F_fconst
+    };
+    if (!control) return 0;
+    for (int i = 0; i < (int) (sizeof(known) / sizeof(known[0])); i++)
+        if (control == known[i]) return i + 1;
+    return -1;
+}
+
+uint64_t F_hashBytes(const char *p, size_t n);
+
+void F_depOf(F_Dict *dict, int idx, int name, F_Dep *d) {
+    memset(d, 0, sizeof(F_Dep));
+    d->idx = idx;
+    d->name = name;
+    d->type = -1;
+    if (idx < 0) return;
+    F_DictEntry *cur = &dict->entry[idx];
+    d->type = cur->type;
+    switch (cur->type) {
+        case F_MODULE:
+        case F_VARIABLE:
+            d->ival = cur->var_index;
+            break;
+        case F_CONSTANT:
+            d->ival = cur->value;
+            break;
+        case F_FCONSTANT:
+            d->fval = cur->fvalue;
+            break;
+        case F_FUNCTION:
+            d->ival = (int) F_hashBytes(cur->expr, strlen(cur->expr));
+            if (F_fresh(dict, cur)) d->effect = cur->code->effect;
+            break;
+        case F_PRIMITIVE:
+            d->ival = cur->func ? F_primOp(cur->func) : -1;
+            d->effect = cur->effect;
+            break;
+        case F_CONTROL:
+            d->ival = F_controlKind(cur->control);
+            break;
+    }
+}
+
+void F_addDep(F_State *state, const char *pool, int idx, int name) {
+    F_DepList *deps = state->deps;
+    for (int i = 0; i < deps->size; i++)
+        if (deps->dep[i].idx == idx && !strcmp(pool + deps->dep[i].name, pool + name)) return;
+    if (deps->size >= deps->capacity) {
+        deps->capacity = deps->capacity ? deps->capacity * 2 : 16;
+        deps->dep = (F_Dep *) realloc(deps->dep, deps->capacity * sizeof(F_Dep));
+    }
+    F_depOf(state->dict, idx, name, &deps->dep[deps->size++]);
+}
+
+void F_addRef(F_Code *code, int ref) {
+    for (int i = 0; i < code->ref_size; i++)
+        if (code->refs[i] == ref) return;
+    if (code->ref_size >= 8 && !(code->ref_size & (code->ref_size - 1)))
+        code->refs = (int *) realloc(code->refs, code->ref_size * 2 * sizeof(int));
+    else if (!code->refs) code->refs = (int *) malloc(8 * sizeof(int));
+    code->refs[code->ref_size++] = ref;
+}
+
+void F_compileSource(F_Compiler *c, const char *s, int i);
+int F_checkedOp(int op);
+
+int F_canInline(F_Compiler *c, int idx) {
+    F_State *state = c->state;
+    F_DictEntry *cur = &state->dict->entry[idx];
+    if (!state->inlining || F_profiling(state) || idx == state->compiling
+        || !F_fresh(state->dict, cur) || c->inline_depth >= F_INLINE_DEPTH) return 0;
+    F_Code *code = cur->code;
+    if (code->locals || code->size - 1 > F_INLINE_SIZE || c->inline_size + code->size - 1 > F_INLINE_BUDGET) return 0;
+    for (int i = 0; i < c->inline_depth; i++)
+        if (c->inline_stack[i] == idx) return 0;
+    for (int i = 0; i < code->size; i++) {
+        switch (F_checkedOp(code->inst[i].op)) {
+            case F_OP_WORD:
+            case F_OP_CONTROL:
+            case F_OP_PCONTROL:
+            case F_OP_DEFVAR:
+            case F_OP_DEFFVAR:
+            case F_OP_DEFCONST:
+            case F_OP_DEFFCONST:
+            case F_OP_ERR:
+                return 0;
+        }
+    }
+    return 1;
+}
+
+void F_inlineWord(F_Compiler *c, int idx) {
+    F_DictEntry *cur = &c->state->dict->entry[idx];
+    int late_size = c->late_size, local_size = c->local_size;
+    c->late_size = c->local_size = 0;
+    c->inline_stack[c->inline_depth++] = idx;
+    c->inline_size += cur->code->size - 1;
+    F_compileSource(c, cur->expr, 0);
+    c->inline_depth--;
+    c->late_size = late_size;
+    c->local_size = local_size;
+    cur->inlined = 1;
+    c->state->inlined++;
+    F_DepList *deps = c->state->deps;
+    for (int i = 0; deps && i < deps->size; i++)
+        if (deps->dep[i].idx == idx) deps->dep[i].inlined = 1;
+}
+
+void F_compileWord(F_Compiler *c, const char *s, int *pos, int name) {
+    F_Code *code = c->code;
+    const char *word = code->pool + name;
+    int i = *pos;
+    if (!strcmp(word, "{")) {
+        F_compileLocals(c, s, pos);
+        return;
+    }
+    int slot = F_findLocal(c, word, (int) strlen(word));
+    if (slot >= 0) {
+        F_compileOp(c, c->local[slot * 2 + 1] ? F_OP_FLGET : F_OP_LGET, slot, 0);
+        return;
+    }
+    if (c->local_size && !strcmp(word, "to")) {
+        while (s[i] == ' ') i++;
+        int start = i;
+        while (s[i] != ' ' && s[i] != '\0') i++;
+        slot = F_findLocal(c, s + start, i - start);
+        if (slot >= 0) {
+            F_compileOp(c, c->local[slot * 2 + 1] ? F_OP_FLSET : F_OP_LSET, slot, 0);
+            *pos = i;
+            return;
+        }
+        i = *pos;
+    }
+    int idx = F_isLate(c, word) ? -1 : F_lookup(c->state->dict, word);
+    if (!F_isLate(c, word)) {
+        F_addRef(code, idx < 0 ? -1 - name : idx);
+        if (c->state->deps) F_addDep(c->state, code->pool, idx, name);
+    }
+    if (idx < 0) {
+        F_compileOp(c, F_OP_WORD, name, i);
+        return;
+    }
+    F_DictEntry *cur = &c->state->dict->entry[idx];
+    switch (cur->type) {
+        case F_MODULE:
+        case F_VARIABLE:
+            F_compileOp(c, F_OP_VAR, cur->var_index, idx);
+            break;
+        case F_CONSTANT:
+            F_compileOp(c, F_OP_LIT, cur->value, 0);
+            break;
+        case F_FCONSTANT:
+            F_compileOp(c, F_OP_FLIT, F_addFloat(code, cur->fvalue), 0);
+            break;
+        case F_FUNCTION:
+            if (F_canInline(c, idx)) F_inlineWord(c, idx);
+            else F_compileOp(c, F_profiling(c->state) ? F_OP_PCALL : F_OP_CALL, idx, 0);
+            break;
+        case F_PRIMITIVE:
+            if (cur->func) F_compileOp(c, F_profiling(c->state) ? F_OP_PPRIM : F_primOp(cur->func), idx, 0);
+            break;
+        case F_CONTROL:
+            if (cur->control == F_if) F_compileIf(c);
+            else if (cur->control == F_else) F_compileElse(c);
+            else if (cur->control == F_begin) F_compileBegin(c);
+            else if (cur->control == F_until) F_compileUntil(c);
+            else if (cur->control == F_var || cur->control == F_fvar || cur->control == F_show
+                     || cur->control == F_const || cur->control == F_fconst) {
+                while (s[i] == ' ') i++;
+                int start = i;
+                while (s[i] != ' ' && s[i] != '\0') i++;
+                name = F_intern(code, s + start, i - start);
+                if (cur->control == F_show) F_compileOp(c, F_OP_SHOW, name, 0);
+                else {
+                    int op = cur->control == F_var ? F_OP_DEFVAR
+                           : cur->control == F_fvar ? F_OP_DEFFVAR
+                           : cur->control == F_const ? F_OP_DEFCONST : F_OP_DEFFCONST;
+                    F_compileOp(c, op, name, 0);
+                    c->late = (int *) realloc(c->late, (c->late_size + 1) * sizeof(int));
+                    c->late[c->late_size++] = name;
+                }
+            } else if (cur->control) {
+                F_compileOp(c, F_profiling(c->state) ? F_OP_PCONTROL : F_OP_CONTROL, idx, i);
+                c->custom = 1;
+            } else if (!strcmp(word, "then")) F_compileThen(c);
+            break;
+        default:
+            break;
+    }
+    *pos = i;
+}
+
+void F_markTailCalls(F_Code *code) {
+    for (int i = 0; i < code->size; i++) {
+        if (code->inst[i].op != F_OP_CALL && code->inst[i].op != F_OP_PCALL) continue;
+        int next = i + 1, hops = 0;
+        while (code->inst[next].op == F_OP_JMP && hops++ < code->size) next = code->inst[next].a;
+        if (code->inst[next].op == F_OP_END) code->inst[i].op = F_OP_TAILCALL;
+        else if (code->inst[next].op == F_OP_PEND) code->inst[i].op = F_OP_PTAILCALL;
+    }
+}
+
+int F_instEffect(F_State *state, F_Code *code, F_Inst *p, F_Effect *e) {
+    F_DictEntry *cur;
+    memset(e, 0, sizeof(F_Effect));
+    switch (p->op) {
+        case F_OP_CALL:
+        case F_OP_TAILCALL:
+        case F_OP_PCALL:
+        case F_OP_PTAILCALL:
+            cur = &state->dict->entry[p->a];
+            if (cur->type == F_FUNCTION && F_fresh(state->dict, cur)) *e = cur->code->effect;
+            break;
+        case F_OP_PRIM:
+            *e = state->dict->entry[p->a].effect;
+            break;
+        case F_OP_PPRIM:
+            cur = &state->dict->entry[p->a];
+            *e = F_primOp(cur->func) == F_OP_PRIM ? cur->effect : F_opEffect(F_primOp(cur->func));
+            break;
+        case F_OP_STR:
+            e->kind = F_EFFECT_KNOWN;
+            e->dpeak = e->dnet = (int) strlen(code->pool + p->a) + 1;
+            break;
+        default:
+            *e = F_opEffect(p->op);
+            break;
+    }
+    return e->kind != F_EFFECT_UNKNOWN;
+}
+
+void F_analyze(F_State *state, F_Code *code) {
+    int n = code->size, *at = (int *) malloc(n * 2 * sizeof(int));
+    int *work = (int *) malloc(n * sizeof(int)), work_size = 0;
+    int dneed = 0, fneed = 0, dexit = 0, fexit = 0, exits = 0, ok = 1;
+    F_Effect e;
+    for (int i = 0; i < n * 2; i++) at[i] = INT_MIN;
+    at[0] = at[1] = 0;
+    work[work_size++] = 0;
+    while (work_size && ok) {
+        int i = work[--work_size], d = at[i * 2], f = at[i * 2 + 1];
+        F_Inst *p = &code->inst[i];
+        int *target = F_jumpTarget(p), next[2], next_size = 0;
+        if (p->op != F_OP_END && p->op != F_OP_PEND) {
+            if (!F_instEffect(state, code, p, &e)) {
+                ok = 0;
+                break;
+            }
+            if (e.dneed - d > dneed) dneed = e.dneed - d;
+            if (e.fneed - f > fneed) fneed = e.fneed - f;
+            d += e.dnet;
+            f += e.fnet;
+            if (target) next[next_size++] = *target;
+            if (p->op != F_OP_JMP && p->op != F_OP_TAILCALL && p->op != F_OP_PTAILCALL) next[next_size++] = i + 1;
+        }
+        if (!next_size) {
+            if (exits++ && (d != dexit || f != fexit)) ok = 0;
+            dexit = d;
+            fexit = f;
+        }
+        for (int k = 0; k < next_size && ok; k++) {
+            int j = next[k];
+            if (at[j * 2] == INT_MIN) {
+                at[j * 2] = d;
+                at[j * 2 + 1] = f;
+                work[work_size++] = j;
+            } else if (at[j * 2] != d || at[j * 2 + 1] != f) ok = 0;
+        }
+    }
+    memset(&code->effect, 0, sizeof(F_Effect));
+    if (ok && exits) {
+        code->effect.kind = F_EFFECT_KNOWN;
+        code->effect.dneed = dneed;
+        code->effect.dnet = dexit;
+        code->effect.fneed = fneed;
+        code->effect.fnet = fexit;
+    }
+    free(at);
+    free(work);
+}
+
+void F_guardBlocks(F_Code *code) {
+    int n = code->size, blocks = 0, extra = 0;
+    char *leader = (char *) calloc(n + 1, 1);
+    int *start = (int *) malloc(n * sizeof(int)), *end = (int *) malloc(n * sizeof(int));
+    F_Effect *guard = (F_Effect *) malloc(n * sizeof(F_Effect));
+    leader[0] = 1;
+    for (int i = 0; i < n; i++) {
+        int *target = F_jumpTarget(&code->inst[i]);
+        if (target) leader[*target] = leader[i + 1] = 1;
+        else if (F_opEffect(code->inst[i].op).kind != F_EFFECT_GUARD) leader[i] = leader[i + 1] = 1;
+    }
+    for (int i = 0; i < n; ) {
+        F_Effect g = {F_EFFECT_GUARD, 0, 0, 0, 0, 0, 0};
+        int j = i, ops = 0, d = 0, f = 0;
+        while (j < n && (j == i || !leader[j]) && F_opEffect(code->inst[j].op).kind == F_EFFECT_GUARD) {
+            F_Effect e = F_opEffect(code->inst[j].op);
+            if (e.dneed - d > g.dneed) g.dneed = e.dneed - d;
+            if (e.fneed - f > g.fneed) g.fneed = e.fneed - f;
+            if (d + e.dpeak > g.dpeak) g.dpeak = d + e.dpeak;
+            if (f + e.fpeak > g.fpeak) g.fpeak = f + e.fpeak;
+            d += e.dnet;
+            f += e.fnet;
+            ops += code->inst[j].op != F_OP_JMP;
+            if (F_jumpTarget(&code->inst[j++])) break;
+        }
+        if (ops >= F_MIN_GUARD) {
+            start[blocks] = i;
+            end[blocks] = j;
+            guard[blocks++] = g;
+            extra += j - i + 2;
+        }
+        i = j > i ? j : i + 1;
+    }
+    free(leader);
+    if (!blocks) {
+        free(start);
+        free(end);
+        free(guard);
+        return;
+    }
+    F_Inst *inst = (F_Inst *) malloc((n + extra) * sizeof(F_Inst));
+    int *map = (int *) malloc(n * sizeof(int)), size = 0, *at = (int *) malloc(blocks * sizeof(int));
+    for (int i = 0, b = 0; i < n; i++) {
+        map[i] = size;
+        if (b < blocks && i == start[b]) {
+            at[b] = size;
+            inst[size++] = (F_Inst) {F_OP_GUARD, b, 0};
+            for (; i < end[b]; i++) {
+                inst[size] = code->inst[i];
+                inst[size++].op = F_uncheckedOp(code->inst[i].op);
+            }
+            i--;
+            b++;
+        } else inst[size++] = code->inst[i];
+    }
+    for (int b = 0; b < blocks; b++) {
+        inst[at[b]].b = size;
+        for (int i = start[b]; i < end[b]; i++) inst[size++] = code->inst[i];
+        if (code->inst[end[b] - 1].op != F_OP_JMP) inst[size++] = (F_Inst) {F_OP_JMP, end[b], 0};
+    }
+    for (int i = 0; i < size; i++) {
+        int *target = F_jumpTarget(&inst[i]);
+        if (target) *target = map[*target];
+    }
+    free(code->inst);
+    code->inst = inst;
+    code->size = code->capacity = size;
+    code->guard = guard;
+    code->guard_size = blocks;
+    free(start);
+    free(end);
+    free(map);
+    free(at);
+}
+
+void F_compileSource(F_Compiler *c, const char *s, int i) {
+    while (s[i] != '\0') {
+        if (s[i] == ' ') {
+            i++;
+            continue;
+        }
+        if (isdigit(s[i]) || (s[i] == '-' && isdigit(s[i + 1]))) {
+            int x;
+            double fx;
+            if (F_scanNum(s, &i, &x, &fx)) F_compileOp(c, F_OP_FLIT, F_addFloat(c->code, fx), 0);
+            else F_compileOp(c, F_OP_LIT, x, 0);
+        } else if (s[i] == '\'' && isprint(s[i + 1])) {
+            int ch, err = F_scanChar(s, &i, &ch);
+            if (err) F_compileOp(c, F_OP_ERR, err, 0);
+            else F_compileOp(c, F_OP_LIT, ch, 0);
+        } else if (s[i] == '"') {
+            int start = ++i;
+            while (s[i] != '"' && s[i] != '\0') i++;
+            F_compileOp(c, F_OP_STR, F_intern(c->code, s + start, i - start), 0);
+            if (s[i] != '\0') i++;
+        } else {
+            int start = i;
+            while (s[i] != ' ' && s[i] != '\0') i++;
+            F_compileWord(c, s, &i, F_intern(c->code, s + start, i - start));
+        }
+    }
+}
+
+void F_seedLocals(F_Compiler *c, const char *s, int end) {
+    F_Compiler head = {0};
+    F_DepList *deps = c->state->deps;
+    head.state = c->state;
+    head.code = F_createCode(s);
+    head.tail = 1;
+    head.inline_depth = F_INLINE_DEPTH;
+    char *src = (char *) malloc(end + 1);
+    memcpy(src, s, end);
+    src[end] = '\0';
+    head.src = src;
+    c->state->deps = NULL;
+    F_compileSource(&head, src, 0);
+    c->state->deps = deps;
+    c->local = (int *) realloc(c->local, (head.local_size + 1) * 2 * sizeof(int));
+    for (int k = 0; k < head.local_size; k++) {
+        const char *name = head.code->pool + head.local[k * 2];
+        c->local[k * 2] = F_intern(c->code, name, (int) strlen(name));
+        c->local[k * 2 + 1] = head.local[k * 2 + 1];
+    }
+    c->local_size = head.local_size;
+    free(src);
+    free(head.late);
+    free(head.local);
+    free(head.ctl);
+    F_freeCode(head.code);
+}
+
+F_Code *F_compileAt(F_State *state, const char *s, int i, int tail) {
+    F_Compiler c = {0};
+    c.state = state;
+    c.code = F_createCode(s);
+    c.src = s;
+    c.tail = tail;
+    c.code->version = state->dict->version;
+    if (tail && i > 0) F_seedLocals(&c, s, i);
+    F_compileSource(&c, s, i);
+    if (c.ctl_size) F_compileError(&c, "Unterminated", F_topCtl(&c) == F_CTL_BEGIN ? "begin" : "if");
+    while (c.ctl_size) {
+        int kind = F_topCtl(&c), at = F_popCtl(&c);
+        if (kind != F_CTL_BEGIN) F_patch(&c, at);
+    }
+    c.code->locals = c.local_size;
+    free(c.late);
+    free(c.local);
+    free(c.ctl);
+    if (c.error && !c.tail && !c.custom) {
+        fprintf(stderr, "[ERROR] %s `%s` at line %d\n", c.error, c.error_word, state->line_count);
+        if (!state->interactive) state->running = 0;
+        F_freeCode(c.code);
+        return NULL;
+    }
+    F_emitOp(c.code, F_profiling(state) ? F_OP_PEND : F_OP_END, 0, 0);
+    F_markTailCalls(c.code);
+    F_analyze(state, c.code);
+    if (state->guard) F_guardBlocks(c.code);
+    return c.code;
+}
+
+F_Code *F_build(F_State *state, const char *s) {
+    return F_compileAt(state, s, 0, 0);
+}
+
+#if defined(F_UNIX) && defined(__x86_64__) && !defined(F_NO_JIT) && !defined(F_COUNT_INSTS)
+#define F_JIT
+#endif
+
+void F_freeJit(F_Jit *jit) {
+    if (!jit) return;
+#ifdef F_JIT
+    munmap(jit->mem, jit->len);
+#endif
+    free(jit->inst);
+    free(jit);
+}
+
+int F_checkedOp(int op) {
+    switch (op) {
+#define F_C_CASE(op) case F_OP_U_##op: return F_OP_##op;
+        F_GUARDED(F_C_CASE)
+#undef F_C_CASE
+    }
+    return op;
+}
+
+#ifdef F_JIT
+typedef struct F_Asm {
+    unsigned char *buf;
+    int size;
+    int capacity;
+    int *label;
+    int n;
+    int *fix;
+    int fix_size;
+    int fix_capacity;
+    int exits;
+} F_Asm;
+
+#define F_ASM(a, s) F_asmBytes(a, s, sizeof(s) - 1)
+
+static void F_asmBytes(F_Asm *a, const char *s, int n) {
+    if (a->size + n + 8 > a->capacity) {
+        a->capacity = a->capacity * 2 + n + 8;
+        a->buf = (unsigned char *) realloc(a->buf, a->capacity);
+    }
+    memcpy(a->buf + a->size, s, n);
+    a->size += n;
+}
+
+static void F_asm32(F_Asm *a, int x) {
+    F_asmBytes(a, (const char *) &x, 4);
+}
+
+static void F_asm64(F_Asm *a, uint64_t x) {
+    F_asmBytes(a, (const char *) &x, 8);
+}
+
+static void F_asmJump(F_Asm *a, const char *op, int n, int target) {
+    F_asmBytes(a, op, n);
+    if (a->fix_size + 2 > a->fix_capacity) {
+        a->fix_capacity = a->fix_capacity * 2 + 16;
+        a->fix = (int *) realloc(a->fix, a->fix_capacity * sizeof(int));
+    }
+    a->fix[a->fix_size++] = a->size;
+    a->fix[a->fix_size++] = target;
+    F_asm32(a, 0);
+}
+
+#define F_JMP(a, op, target) F_asmJump(a, op, sizeof(op) - 1, target)
+#define F_EXIT(a, op, r) F_JMP(a, op, (a)->n + (r))
+#define F_OFF(type, field) ((int) offsetof(type, field))
+
+static void F_jitLoad(F_Asm *a) {
+    F_ASM(a, "\x48\x8B\x83"); F_asm32(a, F_OFF(F_State, data));
+    F_ASM(a, "\x4C\x8B\xA0"); F_asm32(a, F_OFF(F_Stack, stack));
+    F_ASM(a, "\x44\x8B\xA8"); F_asm32(a, F_OFF(F_Stack, size));
+    F_ASM(a, "\x44\x8B\xB0"); F_asm32(a, F_OFF(F_Stack, capacity));
+    F_ASM(a, "\x48\x8B\x83"); F_asm32(a, F_OFF(F_State, dict));
+    F_ASM(a, "\x4C\x8B\xB8"); F_asm32(a, F_OFF(F_Dict, vars));
+    F_ASM(a, "\x48\x8B\xAB"); F_asm32(a, F_OFF(F_State, locals.frame));
+}
+
+static void F_jitNeed(F_Asm *a, int n, int i) {
+    F_ASM(a, "\x41\x83\xFD"); F_asmBytes(a, (const char *) &n, 1);
+    F_EXIT(a, "\x0F\x8C", i);
+}
+
+static void F_jitRoom(F_Asm *a, int n, int i) {
+    if (n == 1) {
+        F_ASM(a, "\x45\x39\xF5");
+        F_EXIT(a, "\x0F\x8D", i);
+    } else {
+        F_ASM(a, "\x41\x8D\x45"); F_asmBytes(a, (const char *) &n, 1);
+        F_ASM(a, "\x44\x39\xF0");
+        F_EXIT(a, "\x0F\x8F", i);
+    }
+}
+
+static void F_jitCall(F_Asm *a, void (*fn)(F_State *), int entry, int i) {
+    F_ASM(a, "\x48\x8B\x83"); F_asm32(a, F_OFF(F_State, data));
+    F_ASM(a, "\x44\x89\xA8"); F_asm32(a, F_OFF(F_Stack, size));
+    if (fn) {
+        F_ASM(a, "\x48\xB8"); F_asm64(a, (uint64_t) (uintptr_t) fn);
+    } else {
+        F_ASM(a, "\x48\x8B\x83"); F_asm32(a, F_OFF(F_State, dict));
+        F_ASM(a, "\x48\x8B\x80"); F_asm32(a, F_OFF(F_Dict, entry));
+        F_ASM(a, "\x48\x8B\x80"); F_asm32(a, entry * (int) sizeof(F_DictEntry) + F_OFF(F_DictEntry, func));
+    }
+    F_ASM(a, "\x48\x89\xDF\xFF\xD0");
+    F_jitLoad(a);
+    F_ASM(a, "\x83\xBB"); F_asm32(a, F_OFF(F_State, running)); F_ASM(a, "\x00");
+    F_EXIT(a, "\x0F\x84", i + 1);
+}
+
+static void F_jitFStack(F_Asm *a) {
+    F_ASM(a, "\x48\x8B\x83"); F_asm32(a, F_OFF(F_State, fdata));
+    F_ASM(a, "\x8B\x88"); F_asm32(a, F_OFF(F_FStack, size));
+    F_ASM(a, "\x48\x8B\x90"); F_asm32(a, F_OFF(F_FStack, stack));
+}
+
+static void F_jitFVars(F_Asm *a) {
+    F_ASM(a, "\x48\x8B\xB3"); F_asm32(a, F_OFF(F_State, dict));
+    F_ASM(a, "\x48\x8B\xB6"); F_asm32(a, F_OFF(F_Dict, fvars));
+}
+
+static void F_jitFSize(F_Asm *a) {
+    F_ASM(a, "\x89\x88"); F_asm32(a, F_OFF(F_FStack, size));
+}
+
+static char F_jitSet(int op) {
+    switch (op) {
+        case F_OP_GT: return '\x9F';
+        case F_OP_LT: return '\x9C';
+        case F_OP_GE: return '\x9D';
+        case F_OP_LE: return '\x9E';
+        case F_OP_EQ: return '\x94';
+        default: return '\x95';
+    }
+}
+
+static int F_jitCmp(int op) {
+    switch (op) {
+        case F_OP_GTLIT: case F_OP_JNGT: return F_OP_GT;
+        case F_OP_LTLIT: case F_OP_JNLT: return F_OP_LT;
+        case F_OP_GELIT: case F_OP_JNGE: return F_OP_GE;
+        case F_OP_LELIT: case F_OP_JNLE: return F_OP_LE;
+        case F_OP_EQLIT: case F_OP_JNEQ: return F_OP_EQ;
+        default: return F_OP_NE;
+    }
+}
+
+static void F_jitInst(F_Asm *a, F_Code *code, int i) {
+    F_Inst *p = &code->jit->inst[2 * i + 1];
+    char set[3] = {'\x0F', 0, '\xC0'}, jn[2] = {'\x0F', 0};
+    switch (p->op) {
+        case F_OP_LIT:
+        case F_OP_VAR:
+            F_jitRoom(a, 1, i);
+            F_ASM(a, "\x43\xC7\x44\xAC\x00"); F_asm32(a, p->a);
+            F_ASM(a, "\x41\xFF\xC5");
+            break;
+        case F_OP_ADD:
+        case F_OP_SUB:
+            F_jitNeed(a, 2, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC");
+            if (p->op == F_OP_ADD) F_ASM(a, "\x43\x01\x44\xAC\xF8");
+            else F_ASM(a, "\x43\x29\x44\xAC\xF8");
+            F_ASM(a, "\x41\xFF\xCD");
+            break;
+        case F_OP_MUL:
+            F_jitNeed(a, 2, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xF8\x43\x0F\xAF\x44\xAC\xFC\x43\x89\x44\xAC\xF8\x41\xFF\xCD");
+            break;
+        case F_OP_DIV:
+        case F_OP_MOD:
+            F_jitNeed(a, 2, i);
+            F_ASM(a, "\x43\x8B\x4C\xAC\xFC\x85\xC9");
+            F_EXIT(a, "\x0F\x84", i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xF8\x99\xF7\xF9");
+            if (p->op == F_OP_DIV) F_ASM(a, "\x43\x89\x44\xAC\xF8");
+            else F_ASM(a, "\x43\x89\x54\xAC\xF8");
+            F_ASM(a, "\x41\xFF\xCD");
+            break;
+        case F_OP_GT: case F_OP_LT: case F_OP_GE: case F_OP_LE: case F_OP_EQ: case F_OP_NE:
+            F_jitNeed(a, 2, i);
+            set[1] = F_jitSet(p->op);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC\x43\x39\x44\xAC\xF8");
+            F_asmBytes(a, set, 3);
+            F_ASM(a, "\x0F\xB6\xC0\x43\x89\x44\xAC\xF8\x41\xFF\xCD");
+            break;
+        case F_OP_DROP:
+            F_jitNeed(a, 1, i);
+            F_ASM(a, "\x41\xFF\xCD");
+            break;
+        case F_OP_DUP:
+            F_jitNeed(a, 1, i);
+            F_jitRoom(a, 1, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC\x43\x89\x44\xAC\x00\x41\xFF\xC5");
+            break;
+        case F_OP_SWAP:
+            F_jitNeed(a, 2, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC\x43\x8B\x4C\xAC\xF8\x43\x89\x4C\xAC\xFC\x43\x89\x44\xAC\xF8");
+            break;
+        case F_OP_DEPTH:
+            F_jitRoom(a, 1, i);
+            F_ASM(a, "\x47\x89\x6C\xAC\x00\x41\xFF\xC5");
+            break;
+        case F_OP_FETCH:
+            F_jitNeed(a, 1, i);
+            F_ASM(a, "\x4B\x63\x74\xAC\xFC\x41\x8B\x04\xB7\x43\x89\x44\xAC\xFC");
+            break;
+        case F_OP_STORE: case F_OP_ADDSTORE: case F_OP_SUBSTORE: case F_OP_MULSTORE: case F_OP_DIVSTORE:
+            F_jitNeed(a, 2, i);
+            F_ASM(a, "\x4B\x63\x74\xAC\xFC\x43\x8B\x4C\xAC\xF8");
+            if (p->op == F_OP_STORE) F_ASM(a, "\x41\x89\x0C\xB7");
+            else if (p->op == F_OP_ADDSTORE) F_ASM(a, "\x41\x01\x0C\xB7");
+            else if (p->op == F_OP_SUBSTORE) F_ASM(a, "\x41\x29\x0C\xB7");
+            else if (p->op == F_OP_MULSTORE) F_ASM(a, "\x41\x0F\xAF\x0C\xB7\x41\x89\x0C\xB7");
+            else F_ASM(a, "\x41\x8B\x04\xB7\x99\xF7\xF9\x41\x89\x04\xB7");
+            F_ASM(a, "\x41\x83\xED\x02");
+            break;
+        case F_OP_INC:
+        case F_OP_DEC:
+            F_jitNeed(a, 1, i);
+            F_ASM(a, "\x4B\x63\x74\xAC\xFC");
+            if (p->op == F_OP_INC) F_ASM(a, "\x41\xFF\x04\xB7");
+            else F_ASM(a, "\x41\xFF\x0C\xB7");
+            F_ASM(a, "\x41\xFF\xCD");
+            break;
+        case F_OP_VFETCH:
+            F_jitRoom(a, 1, i);
+            F_ASM(a, "\x41\x8B\x87"); F_asm32(a, p->a * 4);
+            F_ASM(a, "\x43\x89\x44\xAC\x00\x41\xFF\xC5");
+            break;
+        case F_OP_VSTORE: case F_OP_VADDSTORE: case F_OP_VSUBSTORE:
+            F_jitNeed(a, 1, i);
+            F_jitRoom(a, 1, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC");
+            if (p->op == F_OP_VSTORE) F_ASM(a, "\x41\x89\x87");
+            else if (p->op == F_OP_VADDSTORE) F_ASM(a, "\x41\x01\x87");
+            else F_ASM(a, "\x41\x29\x87");
+            F_asm32(a, p->a * 4);
+            F_ASM(a, "\x41\xFF\xCD");
+            break;
+        case F_OP_VINC:
+        case F_OP_VDEC:
+            F_jitRoom(a, 1, i);
+            if (p->op == F_OP_VINC) F_ASM(a, "\x41\xFF\x87");
+            else F_ASM(a, "\x41\xFF\x8F");
+            F_asm32(a, p->a * 4);
+            break;
+        case F_OP_LITVSTORE:
+            F_jitRoom(a, 2, i);
+            F_ASM(a, "\x41\xC7\x87"); F_asm32(a, p->b * 4); F_asm32(a, p->a);
+            break;
+        case F_OP_DUPVSTORE:
+            F_jitNeed(a, 1, i);
+            F_jitRoom(a, 2, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC\x41\x89\x87"); F_asm32(a, p->a * 4);
+            break;
+        case F_OP_ADDLIT:
+        case F_OP_SUBLIT:
+        case F_OP_MULLIT:
+            F_jitNeed(a, 1, i);
+            F_jitRoom(a, 1, i);
+            if (p->op == F_OP_ADDLIT) F_ASM(a, "\x43\x81\x44\xAC\xFC");
+            else if (p->op == F_OP_SUBLIT) F_ASM(a, "\x43\x81\x6C\xAC\xFC");
+            else F_ASM(a, "\x43\x69\x44\xAC\xFC");
+            F_asm32(a, p->a);
+            if (p->op == F_OP_MULLIT) F_ASM(a, "\x43\x89\x44\xAC\xFC");
+            break;
+        case F_OP_GTLIT: case F_OP_LTLIT: case F_OP_GELIT: case F_OP_LELIT: case F_OP_EQLIT: case F_OP_NELIT:
+            F_jitNeed(a, 1, i);
+            F_jitRoom(a, 1, i);
+            set[1] = F_jitSet(F_jitCmp(p->op));
+            F_ASM(a, "\x43\x81\x7C\xAC\xFC"); F_asm32(a, p->a);
+            F_asmBytes(a, set, 3);
+            F_ASM(a, "\x0F\xB6\xC0\x43\x89\x44\xAC\xFC");
+            break;
+        case F_OP_JNGT: case F_OP_JNLT: case F_OP_JNGE: case F_OP_JNLE: case F_OP_JNEQ: case F_OP_JNNE:
+            F_jitNeed(a, 1, i);
+            F_jitRoom(a, 1, i);
+            jn[1] = (char) ((F_jitSet(F_jitCmp(p->op)) - 0x10) ^ 1);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC\x41\xFF\xCD\x3D"); F_asm32(a, p->a);
+            F_asmJump(a, jn, 2, p->b);
+            break;
+        case F_OP_VADD:
+        case F_OP_VSUB:
+        case F_OP_VMUL:
+            F_jitNeed(a, 1, i);
+            F_jitRoom(a, 1, i);
+            F_ASM(a, "\x41\x8B\x87"); F_asm32(a, p->a * 4);
+            if (p->op == F_OP_VADD) F_ASM(a, "\x43\x01\x44\xAC\xFC");
+            else if (p->op == F_OP_VSUB) F_ASM(a, "\x43\x29\x44\xAC\xFC");
+            else F_ASM(a, "\x43\x0F\xAF\x44\xAC\xFC\x43\x89\x44\xAC\xFC");
+            break;
+        case F_OP_SQUARE:
+            F_jitNeed(a, 1, i);
+            F_jitRoom(a, 1, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC\x0F\xAF\xC0\x43\x89\x44\xAC\xFC");
+            break;
+        case F_OP_NIP:
+            F_jitNeed(a, 2, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC\x43\x89\x44\xAC\xF8\x41\xFF\xCD");
+            break;
+        case F_OP_JZ:
+        case F_OP_UNTIL:
+            F_jitNeed(a, 1, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC\x41\xFF\xCD\x85\xC0");
+            F_JMP(a, "\x0F\x84", p->a);
+            break;
+        case F_OP_JMP:
+            F_JMP(a, "\xE9", p->a);
+            break;
+        case F_OP_GUARD: {
+            F_Effect *g = &code->guard[p->a];
+            if (g->dneed) {
+                F_ASM(a, "\x41\x81\xFD"); F_asm32(a, g->dneed);
+                F_JMP(a, "\x0F\x8C", p->b);
+            }
+            if (g->dpeak) {
+                F_ASM(a, "\x41\x8D\x85"); F_asm32(a, g->dpeak);
+                F_ASM(a, "\x44\x39\xF0");
+                F_JMP(a, "\x0F\x8F", p->b);
+            }
+            if (g->fneed || g->fpeak) F_jitFStack(a);
+            if (g->fneed) {
+                F_ASM(a, "\x81\xF9"); F_asm32(a, g->fneed);
+                F_JMP(a, "\x0F\x8C", p->b);
+            }
+            if (g->fpeak) {
+                F_ASM(a, "\x8D\x89"); F_asm32(a, g->fpeak);
+                F_ASM(a, "\x3B\x88"); F_asm32(a, F_OFF(F_FStack, capacity));
+                F_JMP(a, "\x0F\x8F", p->b);
+            }
+            break;
+        }
+        case F_OP_FLIT:
+            F_jitFStack(a);
+            F_ASM(a, "\x3B\x88"); F_asm32(a, F_OFF(F_FStack, capacity));
+            F_EXIT(a, "\x0F\x8D", i);
+            F_ASM(a, "\x49\xB8"); F_asmBytes(a, (const char *) &code->fconst[p->a], 8);
+            F_ASM(a, "\x4C\x89\x04\xCA\xFF\xC1");
+            F_jitFSize(a);
+            break;
+        case F_OP_FADD:
+        case F_OP_FSUB:
+        case F_OP_FMUL:
+            F_jitFStack(a);
+            F_ASM(a, "\x83\xF9\x02");
+            F_EXIT(a, "\x0F\x8C", i);
+            F_ASM(a, "\xF2\x0F\x10\x44\xCA\xF0");
+            if (p->op == F_OP_FADD) F_ASM(a, "\xF2\x0F\x58\x44\xCA\xF8");
+            else if (p->op == F_OP_FSUB) F_ASM(a, "\xF2\x0F\x5C\x44\xCA\xF8");
+            else F_ASM(a, "\xF2\x0F\x59\x44\xCA\xF8");
+            F_ASM(a, "\xF2\x0F\x11\x44\xCA\xF0\xFF\xC9");
+            F_jitFSize(a);
+            break;
+        case F_OP_FVFETCH:
+            F_jitRoom(a, 1, i);
+            F_jitFStack(a);
+            F_ASM(a, "\x3B\x88"); F_asm32(a, F_OFF(F_FStack, capacity));
+            F_EXIT(a, "\x0F\x8D", i);
+            F_jitFVars(a);
+            F_ASM(a, "\x4C\x8B\x86"); F_asm32(a, p->a * 8);
+            F_ASM(a, "\x4C\x89\x04\xCA\xFF\xC1");
+            F_jitFSize(a);
+            break;
+        case F_OP_FVSTORE:
+            F_jitRoom(a, 1, i);
+            F_jitFStack(a);
+            F_ASM(a, "\x85\xC9");
+            F_EXIT(a, "\x0F\x84", i);
+            F_jitFVars(a);
+            F_ASM(a, "\xFF\xC9\x4C\x8B\x04\xCA\x4C\x89\x86"); F_asm32(a, p->a * 8);
+            F_jitFSize(a);
+            break;
+        case F_OP_LGET:
+            F_jitRoom(a, 1, i);
+            F_ASM(a, "\x8B\x85"); F_asm32(a, p->a * (int) sizeof(F_Local));
+            F_ASM(a, "\x43\x89\x44\xAC\x00\x41\xFF\xC5");
+            break;
+        case F_OP_LSET:
+        case F_OP_DUPLSET:
+            F_jitNeed(a, 1, i);
+            F_ASM(a, "\x43\x8B\x44\xAC\xFC\x89\x85"); F_asm32(a, p->a * (int) sizeof(F_Local));
+            if (p->op == F_OP_LSET) F_ASM(a, "\x41\xFF\xCD");
+            break;
+        case F_OP_LITLSET:
+            F_ASM(a, "\xC7\x85"); F_asm32(a, p->b * (int) sizeof(F_Local)); F_asm32(a, p->a);
+            break;
+        case F_OP_LADD:
+        case F_OP_LSUB:
+        case F_OP_LMUL:
+            F_jitNeed(a, 1, i);
+            F_jitRoom(a, 1, i);
+            F_ASM(a, "\x8B\x85"); F_asm32(a, p->a * (int) sizeof(F_Local));
+            if (p->op == F_OP_LADD) F_ASM(a, "\x43\x01\x44\xAC\xFC");
+            else if (p->op == F_OP_LSUB) F_ASM(a, "\x43\x29\x44\xAC\xFC");
+            else F_ASM(a, "\x43\x0F\xAF\x44\xAC\xFC\x43\x89\x44\xAC\xFC");
+            break;
+        case F_OP_FLGET:
+            F_jitFStack(a);
+            F_ASM(a, "\x3B\x88"); F_asm32(a, F_OFF(F_FStack, capacity));
+            F_EXIT(a, "\x0F\x8D", i);
+            F_ASM(a, "\x4C\x8B\x85"); F_asm32(a, p->a * (int) sizeof(F_Local));
+            F_ASM(a, "\x4C\x89\x04\xCA\xFF\xC1");
+            F_jitFSize(a);
+            break;
+        case F_OP_FLSET:
+            F_jitFStack(a);
+            F_ASM(a, "\x85\xC9");
+            F_EXIT(a, "\x0F\x84", i);
+            F_ASM(a, "\xFF\xC9\x4C\x8B\x04\xCA\x4C\x89\x85"); F_asm32(a, p->a * (int) sizeof(F_Local));
+            F_jitFSize(a);
+            break;
+        case F_OP_PRIM:
+            F_jitCall(a, NULL, p->a, i);
+            break;
+        default:
+            if (F_primFunc(p->op)) F_jitCall(a, F_primFunc(p->op), 0, i);
+            else {
+                F_EXIT(a, "\xE9", i);
+                a->exits++;
+            }
+            break;
+    }
+}
+
+static int F_jitAssemble(F_Code *code) {
+    int n = code->size, table, loop = 0;
+    F_Asm a;
+    memset(&a, 0, sizeof(a));
+    for (int i = 0; i < n; i++) {
+        int *t = F_jumpTarget(&code->inst[i]);
+        if (t && *t <= i) loop = 1;
+    }
+    a.n = n;
+    a.label = (int *) malloc((2 * n + 2) * sizeof(int));
+    F_ASM(&a, "\x53\x55\x41\x54\x41\x55\x41\x56\x41\x57\x48\x83\xEC\x08\x48\x89\xFB");
+    F_jitLoad(&a);
+    F_ASM(&a, "\x48\x63\xF6\x48\x8D\x05");
+    int lea = a.size;
+    F_asm32(&a, 0);
+    F_ASM(&a, "\xFF\x24\xF0");
+    for (int i = 0; i < n; i++) {
+        a.label[i] = a.size;
+        F_jitInst(&a, code, i);
+    }
+    if (a.exits && !loop) {
+        free(a.buf);
+        free(a.label);
+        free(a.fix);
+        return 0;
+    }
+    int epilogue = a.size;
+    F_ASM(&a, "\x48\x8B\x8B"); F_asm32(&a, F_OFF(F_State, data));
+    F_ASM(&a, "\x44\x89\xA9"); F_asm32(&a, F_OFF(F_Stack, size));
+    F_ASM(&a, "\x48\x83\xC4\x08\x41\x5F\x41\x5E\x41\x5D\x41\x5C\x5D\x5B\xC3");
+    for (int r = 0; r <= n; r++) {
+        a.label[n + r] = a.size;
+        F_ASM(&a, "\xB8"); F_asm32(&a, r);
+        F_ASM(&a, "\xE9"); F_asm32(&a, epilogue - (a.size + 4));
+    }
+    while (a.size % 8) F_ASM(&a, "\xCC");
+    table = a.size;
+    for (int i = 0; i <= n; i++) F_asm64(&a, 0);
+    for (int k = 0; k < a.fix_size; k += 2) {
+        int at = a.fix[k], rel = a.label[a.fix[k + 1]] - (at + 4);
+        memcpy(a.buf + at, &rel, 4);
+    }
+    int rel = table - (lea + 4);
+    memcpy(a.buf + lea, &rel, 4);
+    size_t len = ((size_t) a.size + 4095) & ~(size_t) 4095;
+    void *mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem != MAP_FAILED) {
+        uint64_t *entry = (uint64_t *) (a.buf + table);
+        for (int i = 0; i < n; i++) entry[i] = (uint64_t) (uintptr_t) mem + a.label[i];
+        entry[n] = (uint64_t) (uintptr_t) mem + a.label[2 * n];
+        memcpy(mem, a.buf, a.size);
+        if (mprotect(mem, len, PROT_READ | PROT_EXEC) < 0) {
+            munmap(mem, len);
+            mem = MAP_FAILED;
+        }
+    }
+    free(a.buf);
+    free(a.label);
+    free(a.fix);
+    if (mem == MAP_FAILED) return -1;
+    code->jit->mem = mem;
+    code->jit->len = len;
+    code->jit->fn = (int (*)(F_State *, int)) mem;
+    return 1;
+}
+#endif
+
+int F_jitCode(F_State *state, F_Code *code) {
+#ifdef F_JIT
+    if (code->jit) return 1;
+    if (!state->jit || code->shared || !code->size) {
+        code->calls = 0;
+        return 0;
+    }
+    int n = code->size;
+    code->jit = (F_Jit *) calloc(1, sizeof(F_Jit));
+    code->jit->inst = (F_Inst *) malloc((2 * n + 2) * sizeof(F_Inst));
+    for (int i = 0; i < n; i++) {
+        code->jit->inst[2 * i] = (F_Inst) {F_OP_JIT, 0, i};
+        code->jit->inst[2 * i + 1] = code->inst[i];
+        code->jit->inst[2 * i + 1].op = F_checkedOp(code->inst[i].op);
+    }
+    code->jit->inst[2 * n] = (F_Inst) {F_OP_JIT, 0, n};
+    code->jit->inst[2 * n + 1] = (F_Inst) {F_OP_END, 0, 0};
+    int r = F_jitAssemble(code);
+    if (r <= 0) {
+        F_freeJit(code->jit);
+        code->jit = NULL;
+        if (r < 0) code->calls = 0;
+        return 0;
+    }
+    code->inst[0] = code->jit->inst[0];
+    state->jitted++;
+    return 1;
+#else
+    (void) state;
+    code->calls = 0;
+    return 0;
+#endif
+}
+
+#if defined(__GNUC__) && !defined(F_DISPATCH_SWITCH)
+#define F_THREADED
+#endif
+
+#ifdef F_COUNT_INSTS
+#define F_TICK state->steps++
+#else
+#define F_TICK (void)0
+#endif
+
+#ifdef F_THREADED
+#define F_LABEL(op) L_##op:
+#define F_ULABEL(op) U_##op: ;
+#define F_NEXT goto *labels[(F_TICK, p = pc++)->op]
+#else
+#define F_LABEL(op) case F_OP_##op:
+#define F_ULABEL(op) case F_OP_U_##op: ;
+#define F_NEXT continue
+#endif
+#define F_SPILL do { \
+        if (dsz) ds[dsz - 1] = tos; \
+        if (fsz) fs[fsz - 1] = ftos; \
+        d->size = dsz; f->size = fsz; \
+    } while (0)
+#define F_FILL do { \
+        ds = d->stack; dsz = d->size; dcap = d->capacity; \
+        fs = f->stack; fsz = f->size; fcap = f->capacity; \
+        if (dsz) tos = ds[dsz - 1]; \
+        if (fsz) ftos = fs[fsz - 1]; \
+    } while (0)
+#define F_DPUSH(x) do { int x_ = (x); if (dsz) ds[dsz - 1] = tos; tos = x_; dsz++; } while (0)
+#define F_DDROP do { if (--dsz) tos = ds[dsz - 1]; } while (0)
+#define F_FPUSH(x) do { double x_ = (x); if (fsz) fs[fsz - 1] = ftos; ftos = x_; fsz++; } while (0)
+#define F_FDROP do { if (--fsz) ftos = fs[fsz - 1]; } while (0)
+#define F_CHECK_NEXT F_FILL; if (!state->running) goto done; else F_NEXT
+#define F_CHECK if (!state->running) goto done
+
+#define F_BINOP(op, fn, cond, expr) F_LABEL(op) \
+    if (dsz >= 2) { \
+        F_ULABEL(op) \
+        int b = tos, a = ds[dsz - 2]; \
+        if (cond) { dsz--; tos = (expr); F_NEXT; } \
+    } \
+    F_SPILL; fn(state); F_CHECK_NEXT;
+
+#define F_FBINOP(op, fn, cond, expr) F_LABEL(op) \
+    if (fsz >= 2) { \
+        F_ULABEL(op) \
+        double b = ftos, a = fs[fsz - 2]; \
+        if (cond) { fsz--; ftos = (expr); F_NEXT; } \
+    } \
+    F_SPILL; fn(state); F_CHECK_NEXT;
+
+#define F_FCMPOP(op, fn, expr) F_LABEL(op) \
+    if (fsz >= 2 && dsz < dcap) { \
+        F_ULABEL(op) \
+        double b = ftos, a = fs[fsz - 2]; \
+        if ((fsz -= 2)) ftos = fs[fsz - 1]; \
+        F_DPUSH(expr); F_NEXT; \
+    } \
+    F_SPILL; fn(state); F_CHECK_NEXT;
+
+#define F_VAROP(op, fn, expr) F_LABEL(op) \
+    if (dsz >= 2) { \
+        F_ULABEL(op) \
+        int *v = &dict->vars[tos], x = ds[dsz - 2]; \
+        if ((dsz -= 2)) tos = ds[dsz - 1]; \
+        expr; F_NEXT; \
+    } \
+    F_SPILL; fn(state); F_CHECK_NEXT;
+
+#define F_FVAROP(op, fn, expr) F_LABEL(op) \
+    if (dsz >= 1 && fsz >= 1) { \
+        F_ULABEL(op) \
+        double *v = &dict->fvars[tos], x = ftos; \
+        F_DDROP; F_FDROP; expr; F_NEXT; \
+    } \
+    F_SPILL; fn(state); F_CHECK_NEXT;
+
+#define F_VSTOREOP(op, fn, expr) F_LABEL(op) \
+    if (dsz >= 1 && dsz < dcap) { \
+        F_ULABEL(op) \
+        int *v = &dict->vars[p->a], x = tos; \
+        F_DDROP; expr; F_NEXT; \
+    } \
+    F_SPILL; F_push(state, p->a); F_CHECK; fn(state); F_CHECK_NEXT;
+
+#define F_LITOP(op, fn, expr) F_LABEL(op) \
+    if (dsz >= 1 && dsz < dcap) { \
+        F_ULABEL(op) \
+        int a = tos, b = p->a; \
+        tos = (expr); F_NEXT; \
+    } \
+    F_SPILL; F_push(state, p->a); F_CHECK; fn(state); F_CHECK_NEXT;
+
+#define F_OSR \
+    if (++code->calls == state->jit_threshold && F_jitCode(state, code)) \
+        pc = code->jit->inst + 2 * (pc - code->inst)
+
+#define F_JNOP(op, fn, expr) F_LABEL(op) \
+    if (dsz >= 1 && dsz < dcap) { \
+        F_ULABEL(op) \
+        int a = tos, b = p->a; \
+        F_DDROP; \
+        if (!(expr)) { pc = code->inst + p->b; F_OSR; } \
+        F_NEXT; \
+    } \
+    F_SPILL; F_push(state, p->a); F_CHECK; fn(state); F_CHECK; \
+    if (!F_pop(state)) pc = code->inst + p->b; \
+    F_CHECK_NEXT;
+
+#define F_VBINOP(op, fn, expr) F_LABEL(op) \
+    if (dsz >= 1 && dsz < dcap) { \
+        F_ULABEL(op) \
+        int a = tos, b = dict->vars[p->a]; \
+        tos = (expr); F_NEXT; \
+    } \
+    F_SPILL; F_push(state, p->a); F_CHECK; F_fetch(state); F_CHECK; fn(state); F_CHECK_NEXT;
+
+#define F_LBINOP(op, fn, expr) F_LABEL(op) \
+    if (dsz >= 1 && dsz < dcap) { \
+        F_ULABEL(op) \
+        int a = tos, b = l->frame[p->a].i; \
+        tos = (expr); F_NEXT; \
+    } \
+    F_SPILL; F_push(state, l->frame[p->a].i); F_CHECK; fn(state); F_CHECK_NEXT;
+
+void F_exec(F_State *state, F_Code *code) {
+    F_run(state, code, -1);
+}
+
+int F_enterLocals(F_State *state, int n) {
+    F_LStack *l = &state->locals;
+    if (l->size + n > l->capacity) {
+        if (l->size + n > l->max) {
+            fprintf(stderr, "[ERROR] Locals stack overflow at line %d\n", state->line_count);
+            if (!state->interactive) state->running = 0;
+            return -1;
+        }
+        while (l->capacity < l->size + n) l->capacity *= 2;
+        if (l->capacity > l->max) l->capacity = l->max;
+        l->slot = (F_Local *) realloc(l->slot, l->capacity * sizeof(F_Local));
+    }
+    l->frame = l->slot + l->size;
+    memset(l->frame, 0, n * sizeof(F_Local));
+    l->size += n;
+    return 0;
+}
+
+void F_run(F_State *state, F_Code *code, int entry) {
+#ifdef F_THREADED
+#define F_OP_LABEL(op) [F_OP_##op] = &&L_##op,
+#define F_BUILTIN_LABEL(op, fn) [F_OP_##op] = &&L_##op,
+#define F_GUARDED_LABEL(op) [F_OP_U_##op] = &&U_##op,
+    static void *labels[F_OP_COUNT] = {
+        F_OPS(F_OP_LABEL) F_BUILTINS(F_BUILTIN_LABEL) F_GUARDED(F_GUARDED_LABEL)
+    };
+#undef F_OP_LABEL
+#undef F_BUILTIN_LABEL
+#undef F_GUARDED_LABEL
+#endif
+    F_Dict *dict = state->dict;
+    F_Stack *d = state->data;
+    F_FStack *f = state->fdata;
+    F_RStack *ret = &state->ret;
+    F_LStack *l = &state->locals;
+    F_Frame *fr;
+    F_Code *owned = NULL;
+    F_Inst *pc = code->inst, *p;
+    F_DictEntry *cur;
+    int outer = ret->frame[ret->size].entry, marked = 0, base;
+    int ltop = l->size, lsize = ltop, lframe = (int) (l->frame - l->slot);
+    int *ds, dsz, dcap, tos = 0;
+    double *fs, ftos = 0;
+    int fsz, fcap;
+    if (outer >= 0 && ret->size + 1 < ret->capacity) {
+        fr = &ret->frame[ret->size];
+        fr->code = NULL;
+        fr->owned = NULL;
+        fr[1].entry = entry;
+        F_PUBLISH();
+        ret->size++;
+        marked = 1;
+    } else ret->frame[ret->size].entry = entry;
+    base = ret->size;
+    state->depth++;
+    if (!state->running) goto done;
+    if (code->locals && F_enterLocals(state, code->locals)) goto done;
+    F_FILL;
+#ifdef F_THREADED
+    F_NEXT;
+#else
+    for (;;) {
+    F_TICK;
+    p = pc++;
+    switch (p->op) {
+#endif
+    F_LABEL(END)
+    end:
+        if (ret->size == base) {
+            F_SPILL;
+            goto done;
+        }
+        F_freeCode(owned);
+        fr = &ret->frame[--ret->size];
+        code = fr->code;
+        pc = fr->pc;
+        owned = fr->owned;
+        l->size = ltop;
+        ltop = fr->ltop;
+        l->frame = l->slot + fr->lframe;
+        F_NEXT;
+    F_LABEL(LIT)
+        if (dsz < dcap) {
+            F_ULABEL(LIT)
+            F_DPUSH(p->a);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_push(state, p->a);
+        F_CHECK_NEXT;
+    F_LABEL(FLIT)
+        if (fsz < fcap) {
+            F_ULABEL(FLIT)
+            F_FPUSH(code->fconst[p->a]);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_fpush(state, code->fconst[p->a]);
+        F_CHECK_NEXT;
+    F_LABEL(VAR)
+        if (dsz < dcap) {
+            F_ULABEL(VAR)
+            F_DPUSH(p->a);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_push(state, p->a);
+        F_CHECK_NEXT;
+    F_LABEL(STR)
+        F_SPILL;
+        F_pushString(state, code->pool + p->a);
+        F_CHECK_NEXT;
+    F_LABEL(ERR)
+        F_SPILL;
+        fprintf(stderr, "[ERROR] %s at line %d\n", F_scanError[p->a], state->line_count);
+        if (!state->interactive) state->running = 0;
+        F_CHECK_NEXT;
+    F_LABEL(WORD)
+        F_SPILL;
+        cur = F_find(state, code->pool + p->a);
+        if (!cur) {
+            fprintf(stderr, "[ERROR] Undefined word `%s` at line %d\n", code->pool + p->a, state->line_count);
+            if (!state->interactive) state->running = 0;
+        } else if (cur->type == F_CONTROL) {
+            if (cur->control) goto control;
+        } else F_execEntry(state, cur);
+        F_CHECK_NEXT;
+    F_LABEL(CALL)
+        cur = &dict->entry[p->a];
+    call:
+        if (cur->type != F_FUNCTION) {
+            F_SPILL;
+            F_execEntry(state, cur);
+            F_CHECK_NEXT;
+        }
+        if (ret->size + 1 >= ret->capacity) {
+            if (ret->capacity > ret->max) {
+                F_SPILL;
+                fprintf(stderr, "[ERROR] Return stack overflow at line %d\n", state->line_count);
+                if (!state->interactive) state->running = 0;
+                goto done;
+            }
+            ret->busy = 1;
+            ret->capacity = ret->capacity * 2 <= ret->max ? ret->capacity * 2 : ret->max + 1;
+            ret->frame = (F_Frame *) realloc(ret->frame, ret->capacity * sizeof(F_Frame));
+            ret->busy = 0;
+        }
+        fr = &ret->frame[ret->size];
+        fr->code = code;
+        fr->pc = pc;
+        fr->owned = owned;
+        fr->ltop = ltop;
+        fr->lframe = (int) (l->frame - l->slot);
+        fr[1].entry = p->a;
+        F_PUBLISH();
+        ret->size++;
+        owned = NULL;
+        code = F_link(state, cur);
+        pc = code->inst;
+        ltop = l->size;
+        if (code->locals && F_enterLocals(state, code->locals)) {
+            F_SPILL;
+            goto done;
+        }
+        F_NEXT;
+    F_LABEL(TAILCALL)
+        cur = &dict->entry[p->a];
+    tailcall:
+        if (cur->type != F_FUNCTION) {
+            F_SPILL;
+            F_execEntry(state, cur);
+            F_CHECK_NEXT;
+        }
+        F_freeCode(owned);
+        owned = NULL;
+        ret->frame[ret->size].entry = p->a;
+        code = F_link(state, cur);
+        pc = code->inst;
+        l->size = ltop;
+        if (code->locals && F_enterLocals(state, code->locals)) {
+            F_SPILL;
+            goto done;
+        }
+        F_NEXT;
+    F_LABEL(PRIM)
+        F_SPILL;
+        dict->entry[p->a].func(state);
+        F_CHECK_NEXT;
+    F_LABEL(PCALL)
+        cur = &dict->entry[p->a];
+        if (cur->type == F_FUNCTION && F_profiling(state))
+            F_profileEnter(state, p->a, state->depth, ret->size + 1);
+        goto call;
+    F_LABEL(PTAILCALL)
+        cur = &dict->entry[p->a];
+        if (cur->type == F_FUNCTION && F_profiling(state)) {
+            F_profileLeave(state, state->depth, ret->size);
+            F_profileEnter(state, p->a, state->depth, ret->size);
+        }
+        goto tailcall;
+    F_LABEL(PEND)
+        if (ret->size > base && F_profiling(state)) F_profileLeave(state, state->depth, ret->size);
+        goto end;
+    F_LABEL(PPRIM)
+        F_SPILL;
+        cur = &dict->entry[p->a];
+        if (F_profiling(state)) {
+            F_profileEnter(state, p->a, state->depth, INT_MAX);
+            cur->func(state);
+            F_profileExit(state);
+        } else cur->func(state);
+        F_CHECK_NEXT;
+    F_LABEL(PCONTROL)
+        F_SPILL;
+        cur = &dict->entry[p->a];
+        if (F_profiling(state)) F_profileEnter(state, p->a, state->depth, INT_MAX);
+        goto control;
+    F_LABEL(CONTROL)
+        F_SPILL;
+        cur = &dict->entry[p->a];
+        goto control;
+    F_LABEL(JIT)
+        F_SPILL;
+        {
+            int r = code->jit->fn(state, p->b);
+            F_FILL;
+            F_CHECK;
+            pc = code->jit->inst + 2 * r + 1;
+        }
+        F_NEXT;
+    F_LABEL(JZ)
+        if (dsz > 0) {
+            F_ULABEL(JZ)
+            int x = tos;
+            F_DDROP;
+            if (!x) pc = code->inst + p->a;
+            F_NEXT;
+        }
+        F_SPILL;
+        if (!F_pop(state)) pc = code->inst + p->a;
+        F_CHECK_NEXT;
+    F_LABEL(JMP)
+        pc = code->inst + p->a;
+        F_NEXT;
+    F_LABEL(UNTIL)
+        if (dsz > 0) {
+            F_ULABEL(UNTIL)
+            int x = tos;
+            F_DDROP;
+            if (!x) {
+                pc = code->inst + p->a;
+                F_OSR;
+            }
+            F_NEXT;
+        }
+        F_SPILL;
+        if (!F_pop(state)) pc = code->inst + p->a;
+        F_CHECK_NEXT;
+    F_LABEL(DEFVAR)
+        F_SPILL;
+        F_defVar(state, code->pool + p->a);
+        F_CHECK_NEXT;
+    F_LABEL(DEFFVAR)
+        F_SPILL;
+        F_defFVar(state, code->pool + p->a);
+        F_CHECK_NEXT;
+    F_LABEL(DEFCONST)
+        F_SPILL;
+        F_defConst(state, code->pool + p->a);
+        F_CHECK_NEXT;
+    F_LABEL(DEFFCONST)
+        F_SPILL;
+        F_defFConst(state, code->pool + p->a);
+        F_CHECK_NEXT;
+    F_LABEL(SHOW)
+        F_SPILL;
+        F_showWord(state, code->pool + p->a);
+        F_CHECK_NEXT;
+
+    F_LABEL(GUARD)
+        {
+            F_Effect *g = &code->guard[p->a];
+            if (dsz < g->dneed || dsz + g->dpeak > dcap || fsz < g->fneed || fsz + g->fpeak > fcap)
+                pc = code->inst + p->b;
+        }
+        F_NEXT;
+
+    F_BINOP(ADD, F_add, 1, a + b)
+    F_BINOP(SUB, F_sub, 1, a - b)
+    F_BINOP(MUL, F_mul, 1, a * b)
+    F_BINOP(DIV, F_div, b != 0, a / b)
+    F_BINOP(MOD, F_mod, b != 0, a % b)
+    F_BINOP(GT, F_greater, 1, a > b)
+    F_BINOP(LT, F_less, 1, a < b)
+    F_BINOP(GE, F_greater_equal, 1, a >= b)
+    F_BINOP(LE, F_less_equal, 1, a <= b)
+    F_BINOP(EQ, F_equal, 1, a == b)
+    F_BINOP(NE, F_not_equal, 1, a != b)
+    F_LABEL(DROP)
+        if (dsz > 0) {
+            F_ULABEL(DROP)
+            F_DDROP;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_pop_silent(state);
+        F_CHECK_NEXT;
+    F_LABEL(DUP)
+        if (dsz > 0 && dsz < dcap) {
+            F_ULABEL(DUP)
+            ds[dsz - 1] = tos;
+            dsz++;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_dup(state);
+        F_CHECK_NEXT;
+    F_LABEL(SWAP)
+        if (dsz >= 2) {
+            F_ULABEL(SWAP)
+            int b = tos;
+            tos = ds[dsz - 2];
+            ds[dsz - 2] = b;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_swap(state);
+        F_CHECK_NEXT;
+    F_LABEL(DEPTH)
+        if (dsz < dcap) {
+            F_ULABEL(DEPTH)
+            F_DPUSH(dsz);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_depth(state);
+        F_CHECK_NEXT;
+    F_LABEL(FETCH)
+        if (dsz > 0) {
+            F_ULABEL(FETCH)
+            tos = dict->vars[tos];
+            F_NEXT;
+        }
+        F_SPILL;
+        F_fetch(state);
+        F_CHECK_NEXT;
+    F_VAROP(STORE, F_store, *v = x)
+    F_VAROP(ADDSTORE, F_add_store, *v += x)
+    F_VAROP(SUBSTORE, F_sub_store, *v -= x)
+    F_VAROP(MULSTORE, F_mul_store, *v *= x)
+    F_VAROP(DIVSTORE, F_div_store, *v /= x)
+    F_LABEL(INC)
+        if (dsz > 0) {
+            F_ULABEL(INC)
+            dict->vars[tos]++;
+            F_DDROP;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_increase(state);
+        F_CHECK_NEXT;
+    F_LABEL(DEC)
+        if (dsz > 0) {
+            F_ULABEL(DEC)
+            dict->vars[tos]--;
+            F_DDROP;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_decrease(state);
+        F_CHECK_NEXT;
+
+    F_FBINOP(FADD, F_fadd, 1, a + b)
+    F_FBINOP(FSUB, F_fsub, 1, a - b)
+    F_FBINOP(FMUL, F_fmul, 1, a * b)
+    F_FBINOP(FDIV, F_fdiv, b != 0, a / b)
+    F_FBINOP(FMOD, F_fmod, b != 0, fmod(a, b))
+    F_FCMPOP(FGT, F_fgreater, a > b)
+    F_FCMPOP(FLT, F_fless, a < b)
+    F_FCMPOP(FGE, F_fgreater_equal, a >= b)
+    F_FCMPOP(FLE, F_fless_equal, a <= b)
+    F_FCMPOP(FEQ, F_fequal, a == b)
+    F_FCMPOP(FNE, F_fnot_equal, a != b)
+    F_LABEL(FDROP)
+        if (fsz > 0) {
+            F_ULABEL(FDROP)
+            F_FDROP;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_fpop_silent(state);
+        F_CHECK_NEXT;
+    F_LABEL(FDUP)
+        if (fsz > 0 && fsz < fcap) {
+            F_ULABEL(FDUP)
+            fs[fsz - 1] = ftos;
+            fsz++;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_fdup(state);
+        F_CHECK_NEXT;
+    F_LABEL(FSWAP)
+        if (fsz >= 2) {
+            F_ULABEL(FSWAP)
+            double b = ftos;
+            ftos = fs[fsz - 2];
+            fs[fsz - 2] = b;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_fswap(state);
+        F_CHECK_NEXT;
+    F_LABEL(FDEPTH)
+        if (dsz < dcap) {
+            F_ULABEL(FDEPTH)
+            F_DPUSH(fsz);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_fdepth(state);
+        F_CHECK_NEXT;
+    F_LABEL(FFETCH)
+        if (dsz > 0 && fsz < fcap) {
+            F_ULABEL(FFETCH)
+            double x = dict->fvars[tos];
+            F_DDROP;
+            F_FPUSH(x);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_ffetch(state);
+        F_CHECK_NEXT;
+    F_FVAROP(FSTORE, F_fstore, *v = x)
+    F_FVAROP(FADDSTORE, F_fadd_store, *v += x)
+    F_FVAROP(FSUBSTORE, F_fsub_store, *v -= x)
+    F_FVAROP(FMULSTORE, F_fmul_store, *v *= x)
+    F_FVAROP(FDIVSTORE, F_fdiv_store, *v /= x)
+    F_LABEL(FTOI)
+        if (fsz > 0 && dsz < dcap) {
+            F_ULABEL(FTOI)
+            int x = (int)ftos;
+            F_FDROP;
+            F_DPUSH(x);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_ftoi(state);
+        F_CHECK_NEXT;
+    F_LABEL(ITOF)
+        if (dsz > 0 && fsz < fcap) {
+            F_ULABEL(ITOF)
+            double x = (double)tos;
+            F_DDROP;
+            F_FPUSH(x);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_itof(state);
+        F_CHECK_NEXT;
+
+    F_LABEL(VFETCH)
+        if (dsz < dcap) {
+            F_ULABEL(VFETCH)
+            F_DPUSH(dict->vars[p->a]);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_push(state, p->a);
+        F_CHECK;
+        F_fetch(state);
+        F_CHECK_NEXT;
+    F_VSTOREOP(VSTORE, F_store, *v = x)
+    F_VSTOREOP(VADDSTORE, F_add_store, *v += x)
+    F_VSTOREOP(VSUBSTORE, F_sub_store, *v -= x)
+    F_LABEL(VINC)
+        if (dsz < dcap) {
+            F_ULABEL(VINC)
+            dict->vars[p->a]++;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_push(state, p->a);
+        F_CHECK;
+        F_increase(state);
+        F_CHECK_NEXT;
+    F_LABEL(VDEC)
+        if (dsz < dcap) {
+            F_ULABEL(VDEC)
+            dict->vars[p->a]--;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_push(state, p->a);
+        F_CHECK;
+        F_decrease(state);
+        F_CHECK_NEXT;
+    F_LABEL(FVFETCH)
+        if (dsz < dcap && fsz < fcap) {
+            F_ULABEL(FVFETCH)
+            F_FPUSH(dict->fvars[p->a]);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_push(state, p->a);
+        F_CHECK;
+        F_ffetch(state);
+        F_CHECK_NEXT;
+    F_LABEL(FVSTORE)
+        if (dsz < dcap && fsz >= 1) {
+            F_ULABEL(FVSTORE)
+            dict->fvars[p->a] = ftos;
+            F_FDROP;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_push(state, p->a);
+        F_CHECK;
+        F_fstore(state);
+        F_CHECK_NEXT;
+    F_LABEL(LITVSTORE)
+        if (dsz + 2 <= dcap) {
+            F_ULABEL(LITVSTORE)
+            dict->vars[p->b] = p->a;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_push(state, p->a);
+        F_CHECK;
+        F_push(state, p->b);
+        F_CHECK;
+        F_store(state);
+        F_CHECK_NEXT;
+    F_LABEL(DUPVSTORE)
+        if (dsz >= 1 && dsz + 2 <= dcap) {
+            F_ULABEL(DUPVSTORE)
+            dict->vars[p->a] = tos;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_dup(state);
+        F_CHECK;
+        F_push(state, p->a);
+        F_CHECK;
+        F_store(state);
+        F_CHECK_NEXT;
+    F_LITOP(ADDLIT, F_add, a + b)
+    F_LITOP(SUBLIT, F_sub, a - b)
+    F_LITOP(MULLIT, F_mul, a * b)
+    F_LITOP(GTLIT, F_greater, a > b)
+    F_LITOP(LTLIT, F_less, a < b)
+    F_LITOP(GELIT, F_greater_equal, a >= b)
+    F_LITOP(LELIT, F_less_equal, a <= b)
+    F_LITOP(EQLIT, F_equal, a == b)
+    F_LITOP(NELIT, F_not_equal, a != b)
+    F_JNOP(JNGT, F_greater, a > b)
+    F_JNOP(JNLT, F_less, a < b)
+    F_JNOP(JNGE, F_greater_equal, a >= b)
+    F_JNOP(JNLE, F_less_equal, a <= b)
+    F_JNOP(JNEQ, F_equal, a == b)
+    F_JNOP(JNNE, F_not_equal, a != b)
+    F_VBINOP(VADD, F_add, a + b)
+    F_VBINOP(VSUB, F_sub, a - b)
+    F_VBINOP(VMUL, F_mul, a * b)
+    F_LABEL(SQUARE)
+        if (dsz >= 1 && dsz < dcap) {
+            F_ULABEL(SQUARE)
+            tos *= tos;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_dup(state);
+        F_CHECK;
+        F_mul(state);
+        F_CHECK_NEXT;
+    F_LABEL(NIP)
+        if (dsz >= 2) {
+            F_ULABEL(NIP)
+            dsz--;
+            F_NEXT;
+        }
+        F_SPILL;
+        F_swap(state);
+        F_CHECK;
+        F_pop_silent(state);
+        F_CHECK_NEXT;
+    F_LABEL(LGET)
+        if (dsz < dcap) {
+            F_ULABEL(LGET)
+            F_DPUSH(l->frame[p->a].i);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_push(state, l->frame[p->a].i);
+        F_CHECK_NEXT;
+    F_LABEL(LSET)
+        if (dsz > 0) {
+            F_ULABEL(LSET)
+            l->frame[p->a].i = tos;
+            F_DDROP;
+            F_NEXT;
+        }
+        F_SPILL;
+        l->frame[p->a].i = F_pop(state);
+        F_CHECK_NEXT;
+    F_LABEL(FLGET)
+        if (fsz < fcap) {
+            F_ULABEL(FLGET)
+            F_FPUSH(l->frame[p->a].f);
+            F_NEXT;
+        }
+        F_SPILL;
+        F_fpush(state, l->frame[p->a].f);
+        F_CHECK_NEXT;
+    F_LABEL(FLSET)
+        if (fsz > 0) {
+            F_ULABEL(FLSET)
+            l->frame[p->a].f = ftos;
+            F_FDROP;
+            F_NEXT;
+        }
+        F_SPILL;
+        l->frame[p->a].f = F_fpop(state);
+        F_CHECK_NEXT;
+    F_LBINOP(LADD, F_add, a + b)
+    F_LBINOP(LSUB, F_sub, a - b)
+    F_LBINOP(LMUL, F_mul, a * b)
+    F_LABEL(DUPLSET)
+        if (dsz >= 1) {
+            F_ULABEL(DUPLSET)
+            l->frame[p->a].i = tos;
+            F_NEXT;
+        }
+        F_SPILL;
+        l->frame[p->a].i = F_top(state);
+        F_CHECK_NEXT;
+    F_LABEL(LITLSET)
+        l->frame[p->b].i = p->a;
+        F_NEXT;
+
+#define F_CALL_CASE(op, fn) F_LABEL(op) F_SPILL; fn(state); F_CHECK_NEXT;
+    F_CALL_BUILTINS(F_CALL_CASE)
+#undef F_CALL_CASE
+
+    control:
+        {
+            int pos = p->b;
+            cur->control(state, code->src, &pos);
+            if (p->op == F_OP_PCONTROL && F_profiling(state)) F_profileExit(state);
+            if (pos != p->b) {
+                F_Code *tail = F_compileAt(state, code->src, pos, 1);
+                F_freeCode(owned);
+                code = owned = tail;
+                if (!code) goto done;
+                pc = code->inst;
+            }
+        }
+        F_CHECK_NEXT;
+#ifndef F_THREADED
+    }
+    }
+#endif
+done:
+    if (F_profiling(state)) F_profileLeave(state, state->depth, INT_MIN);
+    F_freeCode(owned);
+    while (ret->size > base) F_freeCode(ret->frame[--ret->size].owned);
+    ret->size -= marked;
+    ret->frame[ret->size].entry = outer;
+    l->size = lsize;
+    l->frame = l->slot + lframe;
+    if (!--state->depth) F_collect(state->dict);
+}
+
+#undef F_SPILL
+#undef F_FILL
+#undef F_DPUSH
+#undef F_DDROP
+#undef F_FPUSH
+#undef F_FDROP
+#undef F_BINOP
+#undef F_FBINOP
+#undef F_FCMPOP
+#undef F_VAROP
+#undef F_FVAROP
+#undef F_VSTOREOP
+#undef F_LITOP
+#undef F_JNOP
+#undef F_OSR
+#undef F_VBINOP
+#undef F_LBINOP
+
+#define F_MODULE_MAGIC "FOOMOD\0\3"
+
+typedef struct F_ModuleHeader {
+    char magic[8];
+    int op_count;
+    int inst_size;
+    int peephole;
+    int guard;
+    int min_guard;
+    int def_count;
+    int inlining;
+    int pad;
+    int64_t mtime;
+    int64_t mtime_nsec;
+    uint64_t size;
+    uint64_t hash;
+    uint64_t path_len;
+} F_ModuleHeader;
+
+typedef struct F_ModuleDir {
+    uint64_t def;
+    uint64_t size;
+    uint64_t word;
+} F_ModuleDir;
+
+typedef struct F_ModuleDef {
+    int expr_len;
+    int dep_count;
+    int size;
+    int fconst_size;
+    int pool_size;
+    int guard_size;
+    int locals;
+    int pad;
+    F_Effect effect;
+    F_Effect prefix;
+} F_ModuleDef;
+
+uint64_t F_hashBytes(const char *p, size_t n) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char) p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static int F_moduleKey(const char *filename, F_ModuleHeader *h) {
+    memset(h, 0, sizeof(F_ModuleHeader));
+    memcpy(h->magic, F_MODULE_MAGIC, 8);
+    h->op_count = F_OP_COUNT;
+    h->inst_size = sizeof(F_Inst);
+    h->min_guard = F_MIN_GUARD;
+    h->path_len = strlen(filename);
+#ifdef F_UNIX
+    struct stat st;
+    if (stat(filename, &st) < 0) return -1;
+    h->size = (uint64_t) st.st_size;
+    h->mtime = (int64_t) st.st_mtime;
+#ifdef __linux__
+    h->mtime_nsec = (int64_t) st.st_mtim.tv_nsec;
+#endif
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+static const char *F_skip(const char *p, size_t n) {
+    return p + (n + 7) / 8 * 8;
+}
+
+static int F_checkDef(const char *def, uint64_t size) {
+    const F_ModuleDef *d = (const F_ModuleDef *) def;
+    if (d->expr_len < 0 || d->dep_count < 0 || d->size < 1 || d->fconst_size < 0 || d->pool_size < 0 ||
+        d->guard_size < 0 || d->locals < 0 || d->locals > F_MAX_LOCALS)
+        return 0;
+    uint64_t need = 0, part[] = {sizeof(F_ModuleDef), (uint64_t) d->expr_len + 1,
+                                 (uint64_t) d->dep_count * sizeof(F_Dep), (uint64_t) d->size * sizeof(F_Inst),
+                                 (uint64_t) d->fconst_size * sizeof(double), (uint64_t) d->pool_size,
+                                 (uint64_t) d->guard_size * sizeof(F_Effect)};
+    for (int k = 0; k < 7; k++) need += (part[k] + 7) / 8 * 8;
+    if (need > size) return 0;
+    const char *expr = F_skip(def, sizeof(F_ModuleDef));
+    const F_Dep *dep = (const F_Dep *) F_skip(expr, d->expr_len + 1);
+    F_Inst *inst = (F_Inst *) F_skip((const char *) dep, d->dep_count * sizeof(F_Dep));
+    const char *pool = F_skip(F_skip((const char *) inst, d->size * sizeof(F_Inst)), d->fconst_size * sizeof(double));
+    const F_Effect *guard = (const F_Effect *) F_skip(pool, d->pool_size);
+    if (memchr(expr, '\0', d->expr_len + 1) != expr + d->expr_len || (d->pool_size && pool[d->pool_size - 1]))
+        return 0;
+    for (int k = 0; k < d->dep_count; k++)
+        if (dep[k].name < 0 || dep[k].name >= d->pool_size) return 0;
+    F_ImageCode ic;
+    memset(&ic, 0, sizeof(ic));
+    ic.size = d->size;
+    ic.fconst_size = d->fconst_size;
+    ic.pool_size = d->pool_size;
+    ic.guard_size = d->guard_size;
+    ic.locals = d->locals;
+    int last = F_checkedOp(inst[d->size - 1].op);
+    if (last != F_OP_END && last != F_OP_PEND && last != F_OP_JMP) return 0;
+    for (int k = 0; k < d->size; k++)
+        if (!F_checkInst(&ic, &inst[k], d->expr_len, F_MAX_VARS, F_MAX_VARS)) return 0;
+    return F_checkGuards(&ic, inst, guard);
+}
+
+F_Code *F_restore(F_State *state, const char *def) {
+    F_Dict *dict = state->dict;
+    const F_ModuleDef *d = (const F_ModuleDef *) def;
+    const char *p = F_skip(def, sizeof(F_ModuleDef));
+    const char *expr = p;
+    p = F_skip(p, d->expr_len + 1);
+    const F_Dep *dep = (const F_Dep *) p;
+    p = F_skip(p, d->dep_count * sizeof(F_Dep));
+    const F_Inst *inst = (const F_Inst *) p;
+    p = F_skip(p, d->size * sizeof(F_Inst));
+    const double *fconst = (const double *) p;
+    p = F_skip(p, d->fconst_size * sizeof(double));
+    const char *pool = p;
+    p = F_skip(p, d->pool_size);
+    const F_Effect *guard = (const F_Effect *) p;
+    for (int k = 0; k < d->dep_count; k++) {
+        int idx = F_lookup(dict, pool + dep[k].name);
+        if (idx >= 0 && idx < dict->pending_cap && dict->pending[idx] && !dict->entry[idx].code)
+            F_link(state, &dict->entry[idx]);
+        F_Dep cur;
+        F_depOf(dict, idx, dep[k].name, &cur);
+        cur.inlined = dep[k].inlined;
+        if (memcmp(&cur, &dep[k], sizeof(F_Dep))) return F_build(state, expr);
+    }
+    for (int k = 0, type; k < d->size; k++) {
+        int a = inst[k].a;
+        if (F_instEntry(&inst[k], &type) && (a < 0 || a >= dict->size || (type >= 0 && (int) dict->entry[a].type != type)))
+            return F_build(state, expr);
+    }
+    for (int k = 0; k < d->dep_count; k++)
+        if (dep[k].inlined && dep[k].idx >= 0) dict->entry[dep[k].idx].inlined = 1;
+    F_Code *code = F_createCode(expr);
+    code->inst = (F_Inst *) realloc(code->inst, (d->size ? d->size : 1) * sizeof(F_Inst));
+    memcpy(code->inst, inst, d->size * sizeof(F_Inst));
+    code->size = code->capacity = d->size;
+    if (d->fconst_size) {
+        code->fconst = (double *) malloc(d->fconst_size * sizeof(double));
+        memcpy(code->fconst, fconst, d->fconst_size * sizeof(double));
+    }
+    code->fconst_size = code->fconst_capacity = d->fconst_size;
+    if (d->pool_size) {
+        code->pool = (char *) malloc(d->pool_size);
+        memcpy(code->pool, pool, d->pool_size);
+    }
+    code->pool_size = code->pool_capacity = d->pool_size;
+    if (d->guard_size) {
+        code->guard = (F_Effect *) malloc(d->guard_size * sizeof(F_Effect));
+        memcpy(code->guard, guard, d->guard_size * sizeof(F_Effect));
+    }
+    code->guard_size = d->guard_size;
+    code->locals = d->locals;
+    code->effect = d->effect;
+    code->prefix = d->prefix;
+    code->version = dict->version;
+    for (int k = 0; k < d->dep_count; k++) F_addRef(code, dep[k].idx < 0 ? -1 - dep[k].name : dep[k].idx);
+    return code;
+}
+
+static int F_loadCache(F_State *state, const char *filename, const char *cache) {
+    F_ModuleHeader key;
+    F_Source src;
+    if (F_moduleKey(filename, &key) < 0 || F_openSource(&src, cache) < 0) return -1;
+    const char *end = src.data + src.size;
+    const F_ModuleHeader *h = (const F_ModuleHeader *) src.data;
+    const char *p = F_skip(src.data, sizeof(F_ModuleHeader));
+    int ok = p <= end && h->path_len == key.path_len && F_skip(p, h->path_len + 1) <= end
+             && !memcmp(h->magic, key.magic, 8) && h->op_count == key.op_count
+             && h->inst_size == key.inst_size && h->min_guard == key.min_guard
+             && h->peephole == state->peephole && h->guard == state->guard && h->inlining == state->inlining
+             && !memcmp(p, filename, key.path_len) && h->def_count >= 0;
+    if (ok && (h->size != key.size || h->mtime != key.mtime || h->mtime_nsec != key.mtime_nsec)) {
+        F_Source text;
+        ok = h->size == key.size && F_openSource(&text, filename) == 0;
+        if (ok) {
+            ok = F_hashBytes(text.data, text.size) == h->hash;
+            F_closeSource(&text);
+        }
+    }
+    int count = ok ? h->def_count : 0;
+    p = F_skip(p, key.path_len + 1);
+    const F_ModuleDir *dir = (const F_ModuleDir *) p;
+    ok = ok && (uint64_t) count <= (uint64_t) (end - p) / sizeof(F_ModuleDir);
+    for (int i = 0; i < count && ok; i++)
+        ok = dir[i].size >= sizeof(F_ModuleDef) && dir[i].size <= src.size && dir[i].def <= src.size - dir[i].size
+             && dir[i].def % 8 == 0 && dir[i].word < src.size
+             && memchr(src.data + dir[i].word, '\0', src.size - dir[i].word)
+             && F_checkDef(src.data + dir[i].def, dir[i].size);
+    if (!ok) {
+        F_closeSource(&src);
+        return -1;
+    }
+    F_Dict *dict = state->dict;
+    for (int i = 0; i < count; i++) {
+        const char *def = src.data + dir[i].def;
+        const char *expr = F_skip(def, sizeof(F_ModuleDef));
+        const char *word = src.data + dir[i].word;
+        F_DictEntry *cur = F_find(state, word);
+        if (!cur) cur = F_newEntry(dict, word);
+        else {
+            F_rebind(state, cur, F_FUNCTION, NULL);
+            if (cur->type == F_FUNCTION) F_retire(dict, cur->code);
+        }
+        cur->expr = state->lazy ? expr : F_arenaDup(dict, expr);
+        cur->type = F_FUNCTION;
+        cur->code = NULL;
+        cur->stale = 0;
+        F_defer(dict, cur, def);
+        F_resolve(state, word);
+    }
+    if (state->lazy) {
+        state->deferred += count;
+        dict->modules = (F_Source *) realloc(dict->modules, (dict->module_count + 1) * sizeof(F_Source));
+        dict->modules[dict->module_count++] = src;
+    } else {
+        int materialized = state->materialized;
+        for (int i = 0; i < count; i++) {
+            F_DictEntry *cur = F_find(state, src.data + dir[i].word);
+            if (!cur->code) F_link(state, cur);
+        }
+        state->materialized = materialized;
+        F_closeSource(&src);
+    }
+    if (!state->depth) F_collect(dict);
+    return 0;
+}
+
+static int F_saveCache(F_State *state, const char *filename, const char *cache,
+                        const char **words, int count) {
+    F_ModuleHeader h;
+    F_Source text;
+    if (F_moduleKey(filename, &h) < 0 || F_openSource(&text, filename) < 0) return -1;
+    h.hash = F_hashBytes(text.data, text.size);
+    F_closeSource(&text);
+    h.peephole = state->peephole;
+    h.guard = state->guard;
+    h.inlining = state->inlining;
+    h.def_count = count;
+    size_t len = strlen(cache);
+    char *tmp = (char *) malloc(len + 5);
+    sprintf(tmp, "%s.tmp", cache);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        free(tmp);
+        return -1;
+    }
+    uint64_t off = 0;
+    F_imageWrite(f, &off, &h, sizeof(h));
+    F_imageWrite(f, &off, filename, h.path_len + 1);
+    uint64_t dir_off = off;
+    F_ModuleDir *dir = (F_ModuleDir *) calloc(count + 1, sizeof(F_ModuleDir));
+    F_imageWrite(f, &off, dir, count * sizeof(F_ModuleDir));
+    size_t names = 0;
+    for (int i = 0; i < count; i++) names += strlen(words[i]) + 1;
+    char *name = (char *) malloc(names + 1);
+    names = 0;
+    for (int i = 0; i < count; i++) {
+        dir[i].word = off + names;
+        strcpy(name + names, words[i]);
+        names += strlen(words[i]) + 1;
+    }
+    F_imageWrite(f, &off, name, names);
+    free(name);
+    F_Dict *dict = state->dict;
+    F_DepList deps = {NULL, 0, 0};
+    for (int i = 0; i < count; i++) {
+        F_DictEntry *cur = F_find(state, words[i]);
+        deps.size = 0;
+        state->deps = &deps;
+        F_Code *code = F_build(state, cur->expr);
+        state->deps = NULL;
+        if (!code) break;
+        F_Code *old = cur->code;
+        if (!old) state->materialized++;
+        F_retire(dict, old);
+        cur->code = code;
+        cur->stale = 0;
+        code->src = cur->expr;
+        F_track(dict, cur, old);
+        F_ModuleDef def;
+        memset(&def, 0, sizeof(def));
+        dir[i].def = off;
+        def.expr_len = (int) strlen(cur->expr);
+        def.dep_count = deps.size;
+        def.size = code->size;
+        def.fconst_size = code->fconst_size;
+        def.pool_size = code->pool_size;
+        def.guard_size = code->guard_size;
+        def.locals = code->locals;
+        def.effect = code->effect;
+        def.prefix = code->prefix;
+        F_imageWrite(f, &off, &def, sizeof(def));
+        F_imageWrite(f, &off, cur->expr, def.expr_len + 1);
+        F_imageWrite(f, &off, deps.dep, deps.size * sizeof(F_Dep));
+        F_imageWrite(f, &off, code->inst, code->size * sizeof(F_Inst));
+        F_imageWrite(f, &off, code->fconst, code->fconst_size * sizeof(double));
+        F_imageWrite(f, &off, code->pool, code->pool_size);
+        F_imageWrite(f, &off, code->guard, code->guard_size * sizeof(F_Effect));
+        dir[i].size = off - dir[i].def;
+    }
+    fseek(f, (long) dir_off, SEEK_SET);
+    fwrite(dir, sizeof(F_ModuleDir), count, f);
+    free(dir);
+    free(deps.dep);
+    if (!state->depth) F_collect(dict);
+    if (fclose(f) == 0 && state->running) rename(tmp, cache);
+    else remove(tmp);
+    free(tmp);
+    return state->running ? 0 : -1;
+}
+
+int F_loadModule(F_State *state, const char *name, const char *filename) {
+    if (!state->running) return -1;
+    int saved_line_count = state->line_count;
+    int saved_interactive = state->interactive;
+    if (F_find(state, name)) {
+        if (state->interactive) {
+            F_puts(state, "[INFO] Already load module `");
+            F_puts(state, name);
+            F_puts(state, "` before\n");
+        }
+        return 0;
+    }
+    F_addMod(state, name, 1);
+    char *cache = (char *) malloc(strlen(filename) + 2);
+    sprintf(cache, "%sc", filename);
+    if (state->module_cache && F_loadCache(state, filename, cache) == 0) {
+        free(cache);
+        return 0;
+    }
+    F_Source src;
+    if (F_openSource(&src, filename) < 0) {
+        fprintf(stderr, "[ERROR] Failed to load module `%s`: %s\n", name, strerror(errno));
+        if (!saved_interactive) state->running = 0;
+        free(cache);
+        return -1;
+    }
+    state->line_count = 0;
+    state->interactive = 0;
+    char *saved_line = state->line;
+    const char **words = NULL;
+    char *seen = NULL;
+    int count = 0, seen_size = 0;
+    while (state->running && F_mread(state, &src) != EOF) {
+        if (state->line[0] == ':') {
+            F_define(state, state->line, state->lazy);
+            F_DictEntry *cur = F_find(state, state->word_buf);
+            if (!cur || cur->type != F_FUNCTION) continue;
+            int idx = (int) (cur - state->dict->entry);
+            if (idx >= seen_size) {
+                seen = (char *) realloc(seen, state->dict->capacity);
+                memset(seen + seen_size, 0, state->dict->capacity - seen_size);
+                seen_size = state->dict->capacity;
+            }
+            if (seen[idx]) continue;
+            seen[idx] = 1;
+            words = (const char **) realloc(words, (count + 1) * sizeof(char *));
+            words[count++] = cur->word;
+        }
+    }
+    free(seen);
+    if (state->running && state->module_cache) F_saveCache(state, filename, cache, words, count);
+    free(words);
+    free(cache);
+    F_closeSource(&src);
+    state->line = saved_line;
+    state->line_count = saved_line_count;
+    state->interactive = saved_interactive;
+    return state->running ? 0 : -1;
+}
+
+void F_initState(F_State *state) {
+    F_addFunc(state, "+", F_add);
+    F_addFunc(state, "-", F_sub);
+    F_addFunc(state, "*", F_mul);
+    F_addFunc(state, "/", F_div);
+    F_addFunc(state, "%", F_mod);
+
+    F_addFunc(state, ">", F_greater);
+    F_addFunc(state, "<", F_less);
+    F_addFunc(state, ">=", F_greater_equal);
+    F_addFunc(state, "<=", F_less_equal);
+    F_addFunc(state, "==", F_equal);
+    F_addFunc(state, "~=", F_not_equal);
+
+    F_addFunc(state, ".", F_pop_stack);
+    F_addFunc(state, ".x", F_pop_silent);
+    F_addFunc(state, ".s", F_print_stack);
+    F_addFunc(state, "dup", F_dup);
+    F_addFunc(state, "swp", F_swap);
+    F_addFunc(state, "pick", F_pick);
+    F_addFunc(state, "!pick", F_pick_set);
+    F_addFunc(state, "depth", F_depth);
+
+    F_addControl(state, "if", F_if);
+    F_addControl(state, "else", F_else);
+    F_addControl(state, "then", NULL);
+    F_addControl(state, "begin", F_begin);
+    F_addControl(state, "until", F_until);
+
+    F_addControl(state, "var", F_var);
+    F_addControl(state, "const", F_const);
+    F_addFunc(state, "@", F_fetch);
+    F_addFunc(state, "!", F_store);
+    F_addFunc(state, "?", F_query);
+    F_addFunc(state, "++", F_increase);
+    F_addFunc(state, "--", F_decrease);
+    F_addFunc(state, "+!", F_add_store);
+    F_addFunc(state, "-!", F_sub_store);
+    F_addFunc(state, "*!", F_mul_store);
+    F_addFunc(state, "/!", F_div_store);
+
+    F_addFunc(state, "emit", F_emit);
+    F_addFunc(state, "<cr>", F_cr);
+    F_addFunc(state, "<space>", F_space);
+    F_addFunc(state, "<tab>", F_tab);
+    F_addFunc(state, "geti", F_geti);
+    F_addFunc(state, "getf", F_getf);
+    F_addFunc(state, "getc", F_getc);
+    F_addControl(state, "show", F_show);
+    F_addFunc(state, "bye", F_bye);
+    
+    F_addFunc(state, "f+", F_fadd);
+    F_addFunc(state, "f-", F_fsub);
+    F_addFunc(state, "f*", F_fmul);
+    F_addFunc(state, "f/", F_fdiv);
+    F_addFunc(state, "f%", F_fmod);
+
+    F_addFunc(state, "f>", F_fgreater);
+    F_addFunc(state, "f<", F_fless);
+    F_addFunc(state, "f>=", F_fgreater_equal);
+    F_addFunc(state, "f<=", F_fless_equal);
+    F_addFunc(state, "f==", F_fequal);
     F_addFunc(state, "f~=", F_fnot_equal);
 
     F_addFunc(state, "f.", F_fpop_stack);
@@ -1251,6 +5802,7 @@ void F_initState(F_State *state) {
     F_addFunc(state, "fdepth", F_fdepth);
 
     F_addControl(state, "fvar", F_fvar);
+    F_addControl(state, "fconst", F_fconst);
     F_addFunc(state, "f@", F_ffetch);
     F_addFunc(state, "f!", F_fstore);
     F_addFunc(state, "f?", F_fquery);
@@ -1276,17 +5828,626 @@ void F_initState(F_State *state) {
 
 void F_execScript(F_State *state, const char *filename) {
     if (filename) {
-        state->input = fopen(filename, "r");
-        if (state->input == NULL) {
+        F_closeSource(&state->source);
+        if (F_openSource(&state->source, filename) < 0) {
             fprintf(stderr, "[ERROR] Failed to open file `%s`: %s\n", filename, strerror(errno));
             return;
         }
         state->interactive = 0;
-    } else puts(F_MSG);
+    } else {
+        F_puts(state, F_MSG);
+        F_putc(state, '\n');
+    }
     while (state->running && F_read(state) != EOF) {
-        if (state->line_buf[0] == ':') F_compile(state, state->line_buf);
-        else if (state->line_buf[0] == '#') F_import(state, state->line_buf);
-        else F_eval(state, state->line_buf);
+        if (state->line[0] == ':') F_compile(state, state->line);
+        else if (state->line[0] == '#') F_import(state, state->line);
+        else F_eval(state, state->line);
+    }
+}
+
+const char *F_cOp(int op) {
+    switch (op) {
+        case F_OP_END: return "goto done";
+        case F_OP_LIT: return "F_C_PUSH(%d)";
+        case F_OP_VAR: return "F_C_PUSH(%d)";
+        case F_OP_ERR: return "F_C_ERR(%d)";
+        case F_OP_JZ: return "F_C_JZ(L%d)";
+        case F_OP_UNTIL: return "F_C_JZ(L%d)";
+        case F_OP_JMP: return "goto L%d";
+        case F_OP_VFETCH: return "F_C_VFETCH(%d)";
+        case F_OP_VSTORE: return "F_C_VSTORE(%d, F_store, *v = x)";
+        case F_OP_VADDSTORE: return "F_C_VSTORE(%d, F_add_store, *v += x)";
+        case F_OP_VSUBSTORE: return "F_C_VSTORE(%d, F_sub_store, *v -= x)";
+        case F_OP_VINC: return "F_C_VSTEP(%d, F_increase, (*v)++)";
+        case F_OP_VDEC: return "F_C_VSTEP(%d, F_decrease, (*v)--)";
+        case F_OP_FVFETCH: return "F_C_FVFETCH(%d)";
+        case F_OP_FVSTORE: return "F_C_FVSTORE(%d)";
+        case F_OP_LITVSTORE: return "F_C_LITVSTORE(%d, %d)";
+        case F_OP_DUPVSTORE: return "F_C_DUPVSTORE(%d)";
+        case F_OP_ADDLIT: return "F_C_LITOP(%d, F_add, a + b)";
+        case F_OP_SUBLIT: return "F_C_LITOP(%d, F_sub, a - b)";
+        case F_OP_MULLIT: return "F_C_LITOP(%d, F_mul, a * b)";
+        case F_OP_GTLIT: return "F_C_LITOP(%d, F_greater, a > b)";
+        case F_OP_LTLIT: return "F_C_LITOP(%d, F_less, a < b)";
+        case F_OP_GELIT: return "F_C_LITOP(%d, F_greater_equal, a >= b)";
+        case F_OP_LELIT: return "F_C_LITOP(%d, F_less_equal, a <= b)";
+        case F_OP_EQLIT: return "F_C_LITOP(%d, F_equal, a == b)";
+        case F_OP_NELIT: return "F_C_LITOP(%d, F_not_equal, a != b)";
+        case F_OP_JNGT: return "F_C_JN(%d, F_greater, a > b, L%d)";
+        case F_OP_JNLT: return "F_C_JN(%d, F_less, a < b, L%d)";
+        case F_OP_JNGE: return "F_C_JN(%d, F_greater_equal, a >= b, L%d)";
+        case F_OP_JNLE: return "F_C_JN(%d, F_less_equal, a <= b, L%d)";
+        case F_OP_JNEQ: return "F_C_JN(%d, F_equal, a == b, L%d)";
+        case F_OP_JNNE: return "F_C_JN(%d, F_not_equal, a != b, L%d)";
+        case F_OP_VADD: return "F_C_VBIN(%d, F_add, a + b)";
+        case F_OP_VSUB: return "F_C_VBIN(%d, F_sub, a - b)";
+        case F_OP_VMUL: return "F_C_VBIN(%d, F_mul, a * b)";
+        case F_OP_SQUARE: return "F_C_SQUARE";
+        case F_OP_NIP: return "F_C_NIP";
+        case F_OP_LGET: return "F_C_LGET(%d)";
+        case F_OP_LSET: return "F_C_LSET(%d)";
+        case F_OP_FLGET: return "F_C_FLGET(%d)";
+        case F_OP_FLSET: return "F_C_FLSET(%d)";
+        case F_OP_LADD: return "F_C_LBIN(%d, F_add, a + b)";
+        case F_OP_LSUB: return "F_C_LBIN(%d, F_sub, a - b)";
+        case F_OP_LMUL: return "F_C_LBIN(%d, F_mul, a * b)";
+        case F_OP_DUPLSET: return "F_C_DUPLSET(%d)";
+        case F_OP_LITLSET: return "F_C_LITLSET(%d, %d)";
+        case F_OP_ADD: return "F_C_BIN(F_add, 1, a + b)";
+        case F_OP_SUB: return "F_C_BIN(F_sub, 1, a - b)";
+        case F_OP_MUL: return "F_C_BIN(F_mul, 1, a * b)";
+        case F_OP_DIV: return "F_C_BIN(F_div, b != 0, a / b)";
+        case F_OP_MOD: return "F_C_BIN(F_mod, b != 0, a %% b)";
+        case F_OP_GT: return "F_C_BIN(F_greater, 1, a > b)";
+        case F_OP_LT: return "F_C_BIN(F_less, 1, a < b)";
+        case F_OP_GE: return "F_C_BIN(F_greater_equal, 1, a >= b)";
+        case F_OP_LE: return "F_C_BIN(F_less_equal, 1, a <= b)";
+        case F_OP_EQ: return "F_C_BIN(F_equal, 1, a == b)";
+        case F_OP_NE: return "F_C_BIN(F_not_equal, 1, a != b)";
+        case F_OP_DROP: return "F_C_OP(dsz > 0, dsz--, F_pop_silent(state))";
+        case F_OP_DUP: return "F_C_OP(dsz > 0 && dsz < dcap, ds[dsz] = ds[dsz - 1]; dsz++, F_dup(state))";
+        case F_OP_SWAP: return "F_C_OP(dsz >= 2, int t = ds[dsz - 1]; ds[dsz - 1] = ds[dsz - 2]; ds[dsz - 2] = t, F_swap(state))";
+        case F_OP_DEPTH: return "F_C_OP(dsz < dcap, ds[dsz] = dsz; dsz++, F_depth(state))";
+        case F_OP_FETCH: return "F_C_OP(dsz > 0, ds[dsz - 1] = V[ds[dsz - 1]], F_fetch(state))";
+        case F_OP_STORE: return "F_C_VAROP(F_store, *v = x)";
+        case F_OP_ADDSTORE: return "F_C_VAROP(F_add_store, *v += x)";
+        case F_OP_SUBSTORE: return "F_C_VAROP(F_sub_store, *v -= x)";
+        case F_OP_MULSTORE: return "F_C_VAROP(F_mul_store, *v *= x)";
+        case F_OP_DIVSTORE: return "F_C_VAROP(F_div_store, *v /= x)";
+        case F_OP_INC: return "F_C_OP(dsz > 0, V[ds[--dsz]]++, F_increase(state))";
+        case F_OP_DEC: return "F_C_OP(dsz > 0, V[ds[--dsz]]--, F_decrease(state))";
+        case F_OP_FADD: return "F_C_FBIN(F_fadd, 1, a + b)";
+        case F_OP_FSUB: return "F_C_FBIN(F_fsub, 1, a - b)";
+        case F_OP_FMUL: return "F_C_FBIN(F_fmul, 1, a * b)";
+        case F_OP_FDIV: return "F_C_FBIN(F_fdiv, b != 0, a / b)";
+        case F_OP_FMOD: return "F_C_FBIN(F_fmod, b != 0, fmod(a, b))";
+        case F_OP_FGT: return "F_C_FCMP(F_fgreater, a > b)";
+        case F_OP_FLT: return "F_C_FCMP(F_fless, a < b)";
+        case F_OP_FGE: return "F_C_FCMP(F_fgreater_equal, a >= b)";
+        case F_OP_FLE: return "F_C_FCMP(F_fless_equal, a <= b)";
+        case F_OP_FEQ: return "F_C_FCMP(F_fequal, a == b)";
+        case F_OP_FNE: return "F_C_FCMP(F_fnot_equal, a != b)";
+        case F_OP_FDROP: return "F_C_OP(fsz > 0, fsz--, F_fpop_silent(state))";
+        case F_OP_FDUP: return "F_C_OP(fsz > 0 && fsz < fcap, fs[fsz] = fs[fsz - 1]; fsz++, F_fdup(state))";
+        case F_OP_FSWAP: return "F_C_OP(fsz >= 2, double t = fs[fsz - 1]; fs[fsz - 1] = fs[fsz - 2]; fs[fsz - 2] = t, F_fswap(state))";
+        case F_OP_FDEPTH: return "F_C_OP(dsz < dcap, ds[dsz++] = fsz, F_fdepth(state))";
+        case F_OP_FFETCH: return "F_C_OP(dsz > 0 && fsz < fcap, fs[fsz++] = FV[ds[--dsz]], F_ffetch(state))";
+        case F_OP_FSTORE: return "F_C_FVAROP(F_fstore, *v = x)";
+        case F_OP_FADDSTORE: return "F_C_FVAROP(F_fadd_store, *v += x)";
+        case F_OP_FSUBSTORE: return "F_C_FVAROP(F_fsub_store, *v -= x)";
+        case F_OP_FMULSTORE: return "F_C_FVAROP(F_fmul_store, *v *= x)";
+        case F_OP_FDIVSTORE: return "F_C_FVAROP(F_fdiv_store, *v /= x)";
+        case F_OP_FTOI: return "F_C_OP(fsz > 0 && dsz < dcap, ds[dsz++] = (int) fs[--fsz], F_ftoi(state))";
+        case F_OP_ITOF: return "F_C_OP(dsz > 0 && fsz < fcap, fs[fsz++] = (double) ds[--dsz], F_itof(state))";
+#define F_C_CALL(op, fn) case F_OP_##op: return "F_C_DO(" #fn "(state))";
+        F_CALL_BUILTINS(F_C_CALL)
+#undef F_C_CALL
+    }
+    return NULL;
+}
+
+typedef enum F_CStepKind {
+    F_C_DEFINE,
+    F_C_MODULE,
+    F_C_LINE
+} F_CStepKind;
+
+typedef struct F_CStep {
+    int kind;
+    int arg;
+    int line_count;
+    F_Code *code;
+} F_CStep;
+
+typedef struct F_CUnit {
+    F_State *state;
+    FILE *out;
+    F_CStep *step;
+    int step_size;
+    int *def;
+    const char **expr;
+    char **name;
+    int def_size;
+    int *count;
+    int *first;
+} F_CUnit;
+
+void F_cString(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char) *s;
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if (c < ' ' || c >= 127) fprintf(out, "\\%03o", c);
+        else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+void F_cDouble(FILE *out, double x) {
+    if (isnan(x)) fputs("NAN", out);
+    else if (isinf(x)) fputs(x > 0 ? "HUGE_VAL" : "-HUGE_VAL", out);
+    else fprintf(out, "%a", x);
+}
+
+int F_cError(const char *msg, const char *word) {
+    fprintf(stderr, "[ERROR] Cannot translate to C: %s `%s`\n", msg, word);
+    return -1;
+}
+
+int F_cStep(F_CUnit *u, int kind, int arg, F_Code *code) {
+    u->step = (F_CStep *) realloc(u->step, (u->step_size + 1) * sizeof(F_CStep));
+    F_CStep *st = &u->step[u->step_size++];
+    st->kind = kind;
+    st->arg = arg;
+    st->line_count = u->state->line_count;
+    st->code = code;
+    return 0;
+}
+
+int F_cAddDef(F_CUnit *u, int idx) {
+    F_DictEntry *cur = &u->state->dict->entry[idx];
+    int k = u->def_size++;
+    u->def = (int *) realloc(u->def, u->def_size * sizeof(int));
+    u->expr = (const char **) realloc(u->expr, u->def_size * sizeof(char *));
+    u->name = (char **) realloc(u->name, u->def_size * sizeof(char *));
+    u->def[k] = idx;
+    u->expr[k] = cur->expr;
+    u->name[k] = (char *) malloc(strlen(cur->word) + 16);
+    int len = sprintf(u->name[k], "w%d_", k);
+    for (const char *c = cur->word; *c; c++)
+        u->name[k][len++] = isalnum((unsigned char) *c) ? *c : '_';
+    u->name[k][len] = '\0';
+    return F_cStep(u, F_C_DEFINE, k, NULL);
+}
+
+int F_cSimulate(F_CUnit *u, F_Code *code, int body) {
+    for (int i = 0; i < code->size; i++) {
+        F_Inst *p = &code->inst[i], *prev = i ? p - 1 : NULL;
+        const char *word = code->pool + p->a;
+        F_DictEntry *cur;
+        switch (p->op) {
+            case F_OP_DEFVAR:
+            case F_OP_DEFFVAR:
+            case F_OP_DEFCONST:
+            case F_OP_DEFFCONST:
+                if (body) return F_cError("definition inside a function", word);
+                cur = F_find(u->state, word);
+                if (p->op == F_OP_DEFVAR) F_addVar(u->state, word, 0);
+                else if (p->op == F_OP_DEFFVAR) F_faddVar(u->state, word, 0);
+                else if (cur && (cur->type == F_CONSTANT || cur->type == F_FCONSTANT))
+                    return F_cError("redefined constant", word);
+                else if (p->op == F_OP_DEFCONST && prev && prev->op == F_OP_LIT)
+                    F_addConst(u->state, word, prev->a);
+                else if (p->op == F_OP_DEFFCONST && prev && prev->op == F_OP_FLIT)
+                    F_faddConst(u->state, word, code->fconst[prev->a]);
+                else return F_cError("constant without a literal value", word);
+                break;
+            case F_OP_CONTROL:
+                return F_cError("custom control word", u->state->dict->entry[p->a].word);
+            default:
+                if (p->op >= F_OP_COUNT || (!F_cOp(p->op) && p->op != F_OP_FLIT && p->op != F_OP_STR
+                    && p->op != F_OP_WORD && p->op != F_OP_CALL && p->op != F_OP_TAILCALL
+                    && p->op != F_OP_PRIM && p->op != F_OP_SHOW))
+                    return F_cError("unsupported instruction", F_opNames[p->op]);
+                break;
+        }
+    }
+    return 0;
+}
+
+void F_cCallee(F_CUnit *u, int idx) {
+    if (u->count[idx] > 1) fprintf(u->out, "(*p%d)", idx);
+    else fputs(u->name[u->first[idx]], u->out);
+}
+
+void F_cCode(F_CUnit *u, F_Code *code, int body) {
+    FILE *out = u->out;
+    char *target = (char *) calloc(code->size + 1, 1);
+    for (int i = 0; i < code->size; i++) {
+        int *t = F_jumpTarget(&code->inst[i]);
+        if (t) target[*t] = 1;
+    }
+    for (int i = 0; i < code->size; i++) {
+        F_Inst *p = &code->inst[i];
+        if (target[i]) fprintf(out, "L%d:\n", i);
+        fputs("    ", out);
+        switch (p->op) {
+            case F_OP_FLIT:
+                fputs("F_C_FPUSH(", out);
+                F_cDouble(out, code->fconst[p->a]);
+                fputc(')', out);
+                break;
+            case F_OP_STR:
+            case F_OP_WORD:
+            case F_OP_SHOW:
+            case F_OP_DEFVAR:
+            case F_OP_DEFFVAR:
+            case F_OP_DEFCONST:
+            case F_OP_DEFFCONST:
+                fprintf(out, "F_C_DO(%s(state, ", p->op == F_OP_STR ? "F_pushString"
+                        : p->op == F_OP_WORD ? "F_cWord" : p->op == F_OP_SHOW ? "F_showWord"
+                        : p->op == F_OP_DEFVAR ? "F_defVar" : p->op == F_OP_DEFFVAR ? "F_defFVar"
+                        : p->op == F_OP_DEFCONST ? "F_defConst" : "F_defFConst");
+                F_cString(out, code->pool + p->a);
+                fputs("))", out);
+                break;
+            case F_OP_PRIM:
+                fputs("F_C_DO(F_cWord(state, ", out);
+                F_cString(out, u->state->dict->entry[p->a].word);
+                fputs("))", out);
+                break;
+            case F_OP_CALL:
+            case F_OP_TAILCALL:
+                if (!u->count[p->a]) {
+                    fputs("F_C_DO(F_cWord(state, ", out);
+                    F_cString(out, u->state->dict->entry[p->a].word);
+                    fputs("))", out);
+                    break;
+                }
+                fputs(p->op == F_OP_TAILCALL && body ? "F_C_TAIL(" : "F_C_DO(", out);
+                F_cCallee(u, p->a);
+                fputs(p->op == F_OP_TAILCALL && body ? ")" : "(state))", out);
+                break;
+            default:
+                fprintf(out, F_cOp(p->op), p->a, p->b);
+                break;
+        }
+        fputs(";\n", out);
+    }
+    free(target);
+}
+
+int F_emitC(F_State *state, const char *filename, FILE *out) {
+    F_Source src;
+    if (F_openSource(&src, filename) < 0) {
+        fprintf(stderr, "[ERROR] Failed to open file `%s`: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    F_CUnit u;
+    memset(&u, 0, sizeof(u));
+    u.state = state;
+    u.out = out;
+    int saved_interactive = state->interactive, saved_guard = state->guard;
+    int saved_cache = state->module_cache, saved_jit = state->jit, saved_inlining = state->inlining, err = 0;
+    char *saved_line = state->line;
+    const char **seen = NULL;
+    int seen_size = 0;
+    state->interactive = 0;
+    state->guard = 0;
+    state->module_cache = 0;
+    state->jit = 0;
+    state->inlining = 0;
+    while (!err && state->running && F_mread(state, &src) != EOF) {
+        char *s = state->line;
+        if (s[0] == ':') F_compile(state, s);
+        else if (s[0] == '#') F_import(state, s);
+        else {
+            F_Code *code = F_build(state, s);
+            if (code && code->size > 1) {
+                err = F_cSimulate(&u, code, 0);
+                F_cStep(&u, F_C_LINE, 0, code);
+            } else F_freeCode(code);
+        }
+        F_Dict *dict = state->dict;
+        if (dict->size > seen_size) {
+            seen = (const char **) realloc(seen, dict->size * sizeof(char *));
+            memset(seen + seen_size, 0, (dict->size - seen_size) * sizeof(char *));
+            seen_size = dict->size;
+        }
+        for (int i = 0; i < dict->size && !err; i++) {
+            F_DictEntry *cur = &dict->entry[i];
+            const char *key = cur->type == F_FUNCTION ? cur->expr : cur->type == F_MODULE ? cur->word : NULL;
+            if (key && key != seen[i]) {
+                if (cur->type == F_MODULE) F_cStep(&u, F_C_MODULE, i, NULL);
+                else F_cAddDef(&u, i);
+            }
+            seen[i] = key;
+        }
+    }
+    if (!state->running) err = -1;
+    F_Code **body = (F_Code **) calloc(u.def_size + 1, sizeof(F_Code *));
+    u.count = (int *) calloc(state->dict->size, sizeof(int));
+    u.first = (int *) calloc(state->dict->size, sizeof(int));
+    for (int k = 0; k < u.def_size && !err; k++) {
+        F_DictEntry *cur = &state->dict->entry[u.def[k]];
+        if (cur->type != F_FUNCTION) {
+            err = F_cError("function redefined as another kind of word", cur->word);
+            break;
+        }
+        if (!u.count[u.def[k]]++) u.first[u.def[k]] = k;
+        body[k] = F_build(state, u.expr[k]);
+        if (!body[k]) err = F_cError("compile error in", cur->word);
+        else err = F_cSimulate(&u, body[k], 1);
+    }
+    if (!err) {
+        fprintf(out, "#define F_AOT\n#include \"foo.h\"\n\n");
+        for (int k = 0; k < u.def_size; k++) fprintf(out, "void %s(F_State *state);\n", u.name[k]);
+        for (int i = 0; i < state->dict->size; i++)
+            if (u.count[i] > 1) fprintf(out, "void (*p%d)(F_State *state) = %s;\n", i, u.name[u.first[i]]);
+        for (int k = 0; k < u.def_size; k++) {
+            fprintf(out, "\nvoid %s(F_State *state) {\n    F_C_ENTER;\n", u.name[k]);
+            if (body[k]->locals) fprintf(out, "    F_C_LOCALS(%d);\n", body[k]->locals);
+            F_cCode(&u, body[k], 1);
+            fprintf(out, "    F_C_LEAVE;\n}\n");
+        }
+        for (int j = 0; j < u.step_size; j++) {
+            F_CStep *st = &u.step[j];
+            if (st->kind != F_C_LINE) continue;
+            fprintf(out, "\nvoid l%d(F_State *state) {\n    F_C_LINE(%d, %d);\n", j,
+                    st->code->prefix.dneed, st->code->prefix.fneed);
+            if (st->code->locals) fprintf(out, "    F_C_LOCALS(%d);\n", st->code->locals);
+            F_cCode(&u, st->code, 0);
+            fprintf(out, "    F_C_RETURN;\n}\n");
+        }
+        fprintf(out, "\nvoid F_C_MAIN(F_State *state) {\n");
+        for (int j = 0; j < u.step_size; j++) {
+            F_CStep *st = &u.step[j];
+            if (st->kind == F_C_LINE) {
+                fprintf(out, "    if (!state->running) return;\n");
+                fprintf(out, "    state->line_count = %d;\n    l%d(state);\n", st->line_count, j);
+            } else if (st->kind == F_C_MODULE) {
+                fputs("    F_cModule(state, ", out);
+                F_cString(out, state->dict->entry[st->arg].word);
+                fputs(");\n", out);
+            } else {
+                int idx = u.def[st->arg];
+                fputs("    F_cDefine(state, ", out);
+                F_cString(out, state->dict->entry[idx].word);
+                fprintf(out, ", %s, ", u.name[st->arg]);
+                F_cString(out, u.expr[st->arg]);
+                fputs(");\n", out);
+                if (u.count[idx] > 1) fprintf(out, "    p%d = %s;\n", idx, u.name[st->arg]);
+            }
+        }
+        fprintf(out, "}\n\n#ifndef F_C_NO_MAIN\nint main(void) {\n");
+        fprintf(out, "    F_State *state = F_createState();\n    F_initState(state);\n");
+        fprintf(out, "    state->interactive = 0;\n    F_cGrowStack();\n    F_C_MAIN(state);\n");
+        fprintf(out, "    F_destroyState(state);\n    return 0;\n}\n#endif\n");
+    }
+    for (int k = 0; k < u.def_size; k++) {
+        F_freeCode(body[k]);
+        free(u.name[k]);
+    }
+    for (int j = 0; j < u.step_size; j++) F_freeCode(u.step[j].code);
+    free(body);
+    free(u.count);
+    free(u.first);
+    free(u.def);
+    free(u.expr);
+    free(u.name);
+    free(u.step);
+    free(seen);
+    F_closeSource(&src);
+    state->line = saved_line;
+    state->interactive = saved_interactive;
+    state->guard = saved_guard;
+    state->module_cache = saved_cache;
+    state->jit = saved_jit;
+    state->inlining = saved_inlining;
+    return err ? -1 : 0;
+}
+
+#ifdef F_AOT
+#ifndef F_AOT_STACK
+#define F_AOT_STACK (1u << 20)
+#endif
+#ifndef F_AOT_GROW
+#define F_AOT_GROW (128u << 20)
+#endif
+#ifndef F_C_MAIN
+#define F_C_MAIN F_main
+#endif
+
+int F_cDepth;
+uintptr_t F_cFloor;
+
+uintptr_t F_cStack(void) {
+    static uintptr_t size;
+    if (!size) {
+        size = F_AOT_STACK;
+#ifdef F_UNIX
+        struct rlimit rl;
+        if (!getrlimit(RLIMIT_STACK, &rl))
+            size = rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur > (1u << 30) ? (1u << 30) : (uintptr_t) rl.rlim_cur;
+#endif
+        size -= size / 4;
     }
+    return size;
+}
+
+void F_cGrowStack(void) {
+#ifdef __linux__
+    struct rlimit rl;
+    rlim_t want = (rlim_t) F_AOT_GROW;
+    if (!getrlimit(RLIMIT_STACK, &rl) && rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur < want) {
+        rl.rlim_cur = rl.rlim_max != RLIM_INFINITY && rl.rlim_max < want ? rl.rlim_max : want;
+        setrlimit(RLIMIT_STACK, &rl);
+    }
+#endif
+}
+
+void F_cWord(F_State *state, const char *word) {
+    F_DictEntry *cur = F_find(state, word);
+    if (!cur) {
+        fprintf(stderr, "[ERROR] Undefined word `%s` at line %d\n", word, state->line_count);
+        if (!state->interactive) state->running = 0;
+    } else if (cur->type != F_CONTROL) F_execEntry(state, cur);
 }
+
+void F_cDefine(F_State *state, const char *word, void (*func)(F_State *), const char *expr) {
+    F_DictEntry *cur = F_find(state, word);
+    if (!cur) {
+        F_addFunc(state, word, func);
+        cur = F_find(state, word);
+    } else {
+        if (cur->type == F_FUNCTION) F_retire(state->dict, cur->code);
+        cur->code = NULL;
+        cur->func = func;
+        cur->type = F_PRIMITIVE;
+        memset(&cur->effect, 0, sizeof(F_Effect));
+        state->dict->version++;
+    }
+    cur->expr = F_arenaDup(state->dict, expr);
+}
+
+void F_cModule(F_State *state, const char *name) {
+    if (!F_find(state, name)) F_addMod(state, name, 1);
+}
+
+int F_cUnderflow(F_State *state, int dneed, int fneed) {
+    if (state->data->size >= dneed && state->fdata->size >= fneed) return 0;
+    fprintf(stderr, "[ERROR] Stack underflow at line %d\n", state->line_count);
+    if (!state->interactive) state->running = 0;
+    return 1;
+}
+
+void F_cOverflow(F_State *state) {
+    fprintf(stderr, "[ERROR] Return stack overflow at line %d\n", state->line_count);
+    if (!state->interactive) state->running = 0;
+}
+
+#define F_C_SPILL (d->size = dsz, f->size = fsz)
+#define F_C_FILL (ds = d->stack, dsz = d->size, dcap = d->capacity, \
+                  fs = f->stack, fsz = f->size, fcap = f->capacity)
+#define F_C_CHECK if (!state->running) goto done
+#define F_C_DO(x) do { F_C_SPILL; x; F_C_FILL; F_C_CHECK; } while (0)
+#define F_C_BEGIN \
+    F_Stack *d = state->data; \
+    F_FStack *f = state->fdata; \
+    int *V = state->dict->vars, *ds, dsz, dcap, fsz, fcap; \
+    double *FV = state->dict->fvars, *fs; \
+    F_C_FILL; \
+    (void) V; (void) FV; (void) ds; (void) fs; (void) dcap; (void) fcap
+#define F_C_ENTER F_C_BEGIN; \
+    char sp; \
+    if (++F_cDepth == 1) F_cFloor = (uintptr_t) &sp - F_cStack(); \
+    if (F_cDepth > state->ret.max || (uintptr_t) &sp < F_cFloor) F_C_DO(F_cOverflow(state))
+#define F_C_LEAVE done: F_C_SPILL; F_cDepth--
+#define F_C_LINE(dneed, fneed) if (F_cUnderflow(state, dneed, fneed)) return; F_C_BEGIN
+#define F_C_RETURN done: F_C_SPILL
+#define F_C_TAIL(fn) do { F_C_SPILL; F_cDepth--; fn(state); return; } while (0)
+#define F_C_LOCALS(n) F_Local L[n]; memset(L, 0, sizeof(L))
+
+#define F_C_OP(cond, fast, slow) do { if (cond) { fast; } else F_C_DO(slow); } while (0)
+#define F_C_PUSH(x) F_C_OP(dsz < dcap, ds[dsz++] = (x), F_push(state, x))
+#define F_C_FPUSH(x) F_C_OP(fsz < fcap, fs[fsz++] = (x), F_fpush(state, x))
+#define F_C_ERR(err) F_C_DO(fprintf(stderr, "[ERROR] %s at line %d\n", F_scanError[err], state->line_count); \
+                            if (!state->interactive) state->running = 0)
+#define F_C_JZ(label) do { \
+        if (dsz > 0) { if (!ds[--dsz]) goto label; } \
+        else { int z; F_C_SPILL; z = F_pop(state); F_C_FILL; F_C_CHECK; if (!z) goto label; } \
+    } while (0)
+#define F_C_BIN(fn, cond, expr) do { \
+        if (dsz >= 2) { \
+            int b = ds[dsz - 1], a = ds[dsz - 2]; \
+            if (cond) { ds[dsz - 2] = (expr); dsz--; break; } \
+        } \
+        F_C_DO(fn(state)); \
+    } while (0)
+#define F_C_FBIN(fn, cond, expr) do { \
+        if (fsz >= 2) { \
+            double b = fs[fsz - 1], a = fs[fsz - 2]; \
+            if (cond) { fs[fsz - 2] = (expr); fsz--; break; } \
+        } \
+        F_C_DO(fn(state)); \
+    } while (0)
+#define F_C_FCMP(fn, expr) do { \
+        if (fsz >= 2 && dsz < dcap) { \
+            double b = fs[fsz - 1], a = fs[fsz - 2]; \
+            fsz -= 2; \
+            ds[dsz++] = (expr); \
+        } else F_C_DO(fn(state)); \
+    } while (0)
+#define F_C_VAROP(fn, expr) do { \
+        if (dsz >= 2) { \
+            int *v = &V[ds[dsz - 1]], x = ds[dsz - 2]; \
+            dsz -= 2; \
+            expr; \
+        } else F_C_DO(fn(state)); \
+    } while (0)
+#define F_C_FVAROP(fn, expr) do { \
+        if (dsz >= 1 && fsz >= 1) { \
+            double *v = &FV[ds[--dsz]], x = fs[--fsz]; \
+            expr; \
+        } else F_C_DO(fn(state)); \
+    } while (0)
+#define F_C_SLOW2(n, fn) do { F_C_DO(F_push(state, n)); F_C_DO(fn(state)); } while (0)
+#define F_C_VFETCH(n) do { if (dsz < dcap) ds[dsz++] = V[n]; else F_C_SLOW2(n, F_fetch); } while (0)
+#define F_C_VSTORE(n, fn, expr) do { \
+        if (dsz >= 1 && dsz < dcap) { int *v = &V[n], x = ds[--dsz]; expr; } \
+        else F_C_SLOW2(n, fn); \
+    } while (0)
+#define F_C_VSTEP(n, fn, expr) do { if (dsz < dcap) { int *v = &V[n]; expr; } else F_C_SLOW2(n, fn); } while (0)
+#define F_C_FVFETCH(n) do { \
+        if (dsz < dcap && fsz < fcap) fs[fsz++] = FV[n]; \
+        else F_C_SLOW2(n, F_ffetch); \
+    } while (0)
+#define F_C_FVSTORE(n) do { \
+        if (dsz < dcap && fsz >= 1) FV[n] = fs[--fsz]; \
+        else F_C_SLOW2(n, F_fstore); \
+    } while (0)
+#define F_C_LITVSTORE(x, n) do { \
+        if (dsz + 2 <= dcap) V[n] = (x); \
+        else { F_C_DO(F_push(state, x)); F_C_SLOW2(n, F_store); } \
+    } while (0)
+#define F_C_DUPVSTORE(n) do { \
+        if (dsz >= 1 && dsz + 2 <= dcap) V[n] = ds[dsz - 1]; \
+        else { F_C_DO(F_dup(state)); F_C_SLOW2(n, F_store); } \
+    } while (0)
+#define F_C_LITOP(n, fn, expr) do { \
+        if (dsz >= 1 && dsz < dcap) { int a = ds[dsz - 1], b = (n); ds[dsz - 1] = (expr); } \
+        else F_C_SLOW2(n, fn); \
+    } while (0)
+#define F_C_VBIN(n, fn, expr) do { \
+        if (dsz >= 1 && dsz < dcap) { int a = ds[dsz - 1], b = V[n]; ds[dsz - 1] = (expr); } \
+        else { F_C_SLOW2(n, F_fetch); F_C_DO(fn(state)); } \
+    } while (0)
+#define F_C_JN(n, fn, expr, label) do { \
+        if (dsz >= 1 && dsz < dcap) { \
+            int a = ds[--dsz], b = (n); \
+            if (!(expr)) goto label; \
+        } else { \
+            F_C_SLOW2(n, fn); \
+            F_C_JZ(label); \
+        } \
+    } while (0)
+#define F_C_SQUARE do { \
+        if (dsz >= 1 && dsz < dcap) ds[dsz - 1] *= ds[dsz - 1]; \
+        else { F_C_DO(F_dup(state)); F_C_DO(F_mul(state)); } \
+    } while (0)
+#define F_C_NIP do { \
+        if (dsz >= 2) { ds[dsz - 2] = ds[dsz - 1]; dsz--; } \
+        else { F_C_DO(F_swap(state)); F_C_DO(F_pop_silent(state)); } \
+    } while (0)
+#define F_C_LGET(n) F_C_OP(dsz < dcap, ds[dsz++] = L[n].i, F_push(state, L[n].i))
+#define F_C_LSET(n) F_C_OP(dsz > 0, L[n].i = ds[--dsz], L[n].i = F_pop(state))
+#define F_C_FLGET(n) F_C_OP(fsz < fcap, fs[fsz++] = L[n].f, F_fpush(state, L[n].f))
+#define F_C_FLSET(n) F_C_OP(fsz > 0, L[n].f = fs[--fsz], L[n].f = F_fpop(state))
+#define F_C_LBIN(n, fn, expr) do { \
+        if (dsz >= 1 && dsz < dcap) { int a = ds[dsz - 1], b = L[n].i; ds[dsz - 1] = (expr); } \
+        else { F_C_DO(F_push(state, L[n].i)); F_C_DO(fn(state)); } \
+    } while (0)
+#define F_C_DUPLSET(n) F_C_OP(dsz >= 1, L[n].i = ds[dsz - 1], L[n].i = F_top(state))
+#define F_C_LITLSET(x, n) (L[n].i = (x))
+#endif
 #endif //FOO_H
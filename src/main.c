@@ -6,10 +6,126 @@
 
 #include "foo.h"
 
+typedef struct Capture {
+    char *buf;
+    size_t size;
+    size_t cap;
+} Capture;
+
+static void capture(void *ctx, const char *buf, size_t len) {
+    Capture *c = (Capture *) ctx;
+    if (c->size + len > c->cap) {
+        c->cap = (c->size + len) * 2;
+        c->buf = (char *) realloc(c->buf, c->cap);
+    }
+    memcpy(c->buf + c->size, buf, len);
+    c->size += len;
+}
+
+static int jitDiff(const char *script, const char *path) {
+    Capture out[2] = {{NULL, 0, 0}, {NULL, 0, 0}};
+    for (int k = 0; k < 2; k++) {
+        F_State *fState = F_createState();
+        F_initState(fState);
+        F_setPath(fState, path);
+        fState->module_cache = 0;
+        fState->jit = k;
+        fState->jit_threshold = 1;
+        F_setSink(fState, capture, &out[k]);
+        F_execScript(fState, script);
+        F_destroyState(fState);
+    }
+    size_t i = 0, line = 1;
+    while (i < out[0].size && i < out[1].size && out[0].buf[i] == out[1].buf[i])
+        if (out[0].buf[i++] == '\n') line++;
+    int same = out[0].size == out[1].size && i == out[0].size;
+    if (same) fprintf(stderr, "[INFO] Interpreter and JIT output match (%zu bytes)\n", i);
+    else fprintf(stderr, "[ERROR] Interpreter and JIT output differ at line %zu\n", line);
+    free(out[0].buf);
+    free(out[1].buf);
+    return same ? 0 : 1;
+}
+
+static int emitC(const char *script, const char *target, const char *path) {
+    FILE *out = strcmp(target, "-") ? fopen(target, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "[ERROR] Failed to open `%s`: %s\n", target, strerror(errno));
+        return 1;
+    }
+    F_State *fState = F_createState();
+    F_initState(fState);
+    F_setPath(fState, path);
+    int err = F_emitC(fState, script, out);
+    F_destroyState(fState);
+    if (out != stdout) fclose(out);
+    if (err && out != stdout) remove(target);
+    return err ? 1 : 0;
+}
+
 int main(int argc, char *argv[]) {
+    const char *script = NULL, *image = NULL, *save = NULL, *path = getenv("FOO_PATH");
+    const char *profile_out = NULL, *sample_out = NULL, *emit = NULL;
+    int cache = 1, profile = 0, sample_hz = 1000, jit = 1, diff = 0, threshold = 0, inlining = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--image") && i + 1 < argc) image = argv[++i];
+        else if (!strcmp(argv[i], "--save-image") && i + 1 < argc) save = argv[++i];
+        else if (!strcmp(argv[i], "--path") && i + 1 < argc) path = argv[++i];
+        else if (!strcmp(argv[i], "--no-cache")) cache = 0;
+        else if (!strcmp(argv[i], "--profile")) profile = 1;
+        else if (!strcmp(argv[i], "--profile-out") && i + 1 < argc) profile_out = argv[++i];
+        else if (!strcmp(argv[i], "--sample") && i + 1 < argc) sample_out = argv[++i];
+        else if (!strcmp(argv[i], "--sample-hz") && i + 1 < argc) sample_hz = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--no-jit")) jit = 0;
+        else if (!strcmp(argv[i], "--jit-threshold") && i + 1 < argc) threshold = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--jit-diff")) diff = 1;
+        else if (!strcmp(argv[i], "--no-inline")) inlining = 0;
+        else if (!strcmp(argv[i], "--emit-c") && i + 1 < argc) emit = argv[++i];
+        else script = argv[i];
+    }
+    if ((diff || emit) && !script) {
+        fprintf(stderr, "[ERROR] %s needs a script\n", diff ? "--jit-diff" : "--emit-c");
+        return 1;
+    }
+    if (diff) return jitDiff(script, path);
+    if (emit) return emitC(script, emit, path);
     F_State *fState = F_createState();
     F_initState(fState);
-    F_execScript(fState, argc > 1 ? argv[1] : NULL);
+    F_setPath(fState, path);
+    fState->module_cache = cache;
+    fState->jit = jit;
+    fState->inlining = inlining;
+    if (threshold > 0) fState->jit_threshold = threshold;
+    if (image && F_loadImage(fState, image) < 0) {
+        F_destroyState(fState);
+        return 1;
+    }
+    if (profile || profile_out) F_profileStart(fState);
+    if (sample_out && F_sampleStart(fState, sample_hz) < 0) {
+        fprintf(stderr, "[ERROR] Failed to start the sampler at %d Hz\n", sample_hz);
+        sample_out = NULL;
+    }
+    F_execScript(fState, script);
+    if (sample_out) {
+        F_sampleStop(fState);
+        FILE *out = fopen(sample_out, "w");
+        if (out) {
+            F_sampleDump(fState, out);
+            fclose(out);
+        } else fprintf(stderr, "[ERROR] Failed to open `%s`: %s\n", sample_out, strerror(errno));
+        if (fState->sampler->dropped)
+            fprintf(stderr, "[INFO] Dropped %d samples\n", fState->sampler->dropped);
+    }
+    if (profile || profile_out) {
+        F_profileStop(fState);
+        FILE *out = profile_out ? fopen(profile_out, "w") : stderr;
+        if (out) {
+            const char *ext = profile_out ? strrchr(profile_out, '.') : NULL;
+            F_profileDump(fState, out, !profile_out ? F_PROFILE_TABLE
+                          : ext && !strcmp(ext, ".json") ? F_PROFILE_JSON : F_PROFILE_CSV);
+            if (out != stderr) fclose(out);
+        } else fprintf(stderr, "[ERROR] Failed to open `%s`: %s\n", profile_out, strerror(errno));
+    }
+    if (save) F_saveImage(fState, save);
     F_destroyState(fState);
     return 0;
 }
\ No newline at end of file